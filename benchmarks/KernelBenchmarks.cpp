@@ -0,0 +1,167 @@
+// Micro-benchmarks of the DSP and arp kernels on their own, included from Catch2Main.cpp
+
+namespace
+{
+    // Keeps results alive so the optimiser can't drop the work being measured
+    volatile float kernelSink = 0.0f;
+
+    /** Benchmarks fn, which processes samplesPerRun samples per call, then reports its cost in ns/sample. */
+    template <typename Fn>
+    void benchmarkPerSample (const juce::String& name, int samplesPerRun, Fn&& fn)
+    {
+        BENCHMARK (name.toStdString())
+        {
+            return fn();
+        };
+
+        constexpr int numRuns = 4096;
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < numRuns; ++i)
+            kernelSink = fn();
+
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << name << ": " << juce::String (elapsed.count() / (numRuns * samplesPerRun), 3) << " ns/sample" << std::endl;
+    }
+
+    constexpr double kernelSampleRate = 48000.0;
+    constexpr int kernelBlockSize = 512;
+}
+
+TEST_CASE ("ADSR kernels", "[kernels]")
+{
+    juce::AudioBuffer<float> buffer (2, kernelBlockSize);
+    buffer.clear();
+
+    // Stages last 10 s so a block never leaves the one being measured
+    struct Stage
+    {
+        const char* name;
+        ADSR::Parameters parameters;
+        bool release;
+    };
+
+    for (const auto& stage : { Stage { "attack", { 10.0f, 10.0f, 0.5f, 10.0f, 3.0f }, false },
+             Stage { "decay", { 0.0f, 10.0f, 0.5f, 10.0f, 3.0f }, false },
+             Stage { "sustain", { 0.0f, 0.0f, 0.5f, 10.0f, 3.0f }, false },
+             Stage { "release", { 0.0f, 0.0f, 0.5f, 10.0f, 3.0f }, true } })
+    {
+        ADSR adsr;
+        adsr.setSampleRate (kernelSampleRate);
+        adsr.setParameters (stage.parameters);
+
+        benchmarkPerSample (juce::String ("ADSR::applyEnvelopeToBuffer ") + stage.name, kernelBlockSize, [&] {
+            adsr.noteOn();
+
+            if (stage.release)
+                adsr.noteOff();
+
+            adsr.applyEnvelopeToBuffer (buffer, 0, kernelBlockSize);
+            return buffer.getSample (0, 0);
+        });
+    }
+
+    for (bool ascending : { true, false })
+    {
+        benchmarkPerSample (juce::String ("ADSR::curve ") + (ascending ? "ascending" : "descending"), kernelBlockSize, [&] {
+            float sum = 0.0f;
+
+            for (int i = 0; i < kernelBlockSize; ++i)
+                sum += ADSR::curve (static_cast<float> (i) / kernelBlockSize, 3.0f, ascending);
+
+            return sum;
+        });
+    }
+}
+
+TEST_CASE ("Oscillator kernels", "[kernels]")
+{
+    const juce::StringArray names { "sine", "triangle", "saw", "square" };
+
+    std::vector<float> left (kernelBlockSize), right (kernelBlockSize);
+    std::vector<float> envelopes ((size_t) (kernelBlockSize * VoiceBank::groupSize), 1.0f);
+
+    for (int waveform = 0; waveform < Wavetables::numWaveforms; ++waveform)
+    {
+        VoiceBank bank;
+        bank.prepare (kernelSampleRate);
+        bank.resetWaveform (waveform);
+
+        for (int slot = 0; slot < VoiceBank::groupSize; ++slot)
+            bank.startVoice (slot, 110.0 * (slot + 1), 1.0f, 0.0f);
+
+        // One voice on its own, and a full group through the kernel SynthEngine uses
+        benchmarkPerSample ("VoiceBank::renderVoice " + names[waveform], kernelBlockSize, [&] {
+            bank.renderVoice (0, left.data(), kernelBlockSize);
+            return left[0];
+        });
+
+        benchmarkPerSample ("VoiceBank::renderGroup " + names[waveform] + " (per voice)", kernelBlockSize * VoiceBank::groupSize, [&] {
+            bank.renderGroup (0, envelopes.data(), nullptr, left.data(), right.data(), kernelBlockSize);
+            return left[0];
+        });
+    }
+}
+
+TEST_CASE ("SynthEngine render", "[kernels]")
+{
+    for (int numVoices : { 1, 8, 32, 128 })
+    {
+        ParameterSnapshot params;
+        params.polyphony = SynthEngine::maxPolyphony;
+        params.envelope = { 0.001f, 0.001f, 0.8f, 0.1f, 3.0f };
+
+        SynthEngine engine;
+        engine.prepareToPlay (kernelSampleRate, params);
+
+        juce::AudioBuffer<float> buffer (2, kernelBlockSize);
+        buffer.clear();
+
+        // Start the notes in a first block, after that every voice is sustaining
+        ArpEventList events;
+
+        for (int i = 0; i < numVoices; ++i)
+            events.add ({ 0, ArpEvent::Type::noteOn, static_cast<uint8_t> (1 + i / 64), static_cast<uint8_t> (32 + i % 64) });
+
+        engine.renderNextBlock (buffer, events, params);
+        events.clear();
+
+        benchmarkPerSample ("SynthEngine::renderNextBlock " + juce::String (numVoices) + " voices", kernelBlockSize, [&] {
+            buffer.clear();
+            engine.renderNextBlock (buffer, events, params);
+            return buffer.getSample (0, 0);
+        });
+    }
+}
+
+TEST_CASE ("Arpeggiator processBlock", "[kernels]")
+{
+    for (int numHeld : { 1, 4, 16, 64 })
+    {
+        // 1 ms steps on every lane, so each block plays dozens of steps
+        ParameterSnapshot params;
+
+        for (auto& lane : params.lanes)
+            lane.noteDurSamples = static_cast<int> (0.001 * kernelSampleRate);
+
+        Arpeggiator arp;
+        arp.prepareToPlay (kernelSampleRate, kernelBlockSize);
+
+        ArpEventList events;
+        events.prepare (Arpeggiator::getMaxEventsPerBlock (kernelSampleRate, kernelBlockSize));
+        juce::Optional<juce::AudioPlayHead::PositionInfo> noPosition;
+        juce::MidiBuffer midi;
+
+        for (int i = 0; i < numHeld; ++i)
+            midi.addEvent (juce::MidiMessage::noteOn (1, 32 + i, 0.8f), 0);
+
+        arp.processBlock (kernelBlockSize, midi, noPosition, params, events);
+        midi.clear();
+
+        benchmarkPerSample ("Arpeggiator::processBlock " + juce::String (numHeld) + " held notes", kernelBlockSize, [&] {
+            arp.processBlock (kernelBlockSize, midi, noPosition, params, events);
+            return static_cast<float> (events.size());
+        });
+    }
+}
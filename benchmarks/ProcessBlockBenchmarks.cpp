@@ -0,0 +1,210 @@
+// End-to-end processBlock benchmarks, included from Catch2Main.cpp
+
+namespace
+{
+    /** What a processBlock benchmark plays. */
+    struct ProcessBlockSetup
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int waveform = 0; // "osc" choice index
+        int numNotes = 4; // held chord, 0 for silence
+        int numLanes = 1;
+        float noteDur = 0.1f; // seconds per arp step when free-running
+        bool sync = false;
+        int noteDurSync = 3; // 1/16 notes when synced
+        int polyphony = 32;
+        float release = 0.005f;
+    };
+
+    /** Reports a playing transport at 120 BPM, moved on by the rig after every block. */
+    class BenchmarkPlayHead : public juce::AudioPlayHead
+    {
+    public:
+        juce::Optional<PositionInfo> getPosition() const override
+        {
+            PositionInfo info;
+            info.setBpm (bpm);
+            info.setTimeInSamples (position);
+            info.setPpqPosition (static_cast<double> (position) / sampleRate * bpm / 60.0);
+            info.setIsPlaying (true);
+            return info;
+        }
+
+        double sampleRate = 48000.0;
+        double bpm = 120.0;
+        juce::int64 position = 0;
+    };
+
+    /** A prepared processor playing a setup, ready to have blocks processed. */
+    class ProcessBlockRig
+    {
+    public:
+        explicit ProcessBlockRig (const ProcessBlockSetup& setupToUse)
+            : setup (setupToUse)
+        {
+            setParameter ("osc", static_cast<float> (setup.waveform));
+            setParameter ("polyphony", static_cast<float> (setup.polyphony));
+            setParameter ("release", setup.release);
+            setParameter ("sync", setup.sync ? 1.0f : 0.0f);
+
+            for (int lane = 0; lane < setup.numLanes; ++lane)
+            {
+                if (lane > 0)
+                    setParameter (Arpeggiator::getLaneParamID ("laneOn", lane), 1.0f);
+
+                // Every step plays the whole chord, so each lane sounds numNotes voices
+                setParameter (Arpeggiator::getLaneParamID ("pattern", lane), static_cast<float> (static_cast<int> (ArpPattern::Mode::chord)));
+                setParameter (Arpeggiator::getLaneParamID ("noteDur", lane), setup.noteDur);
+                setParameter (Arpeggiator::getLaneParamID ("noteDurSync", lane), static_cast<float> (setup.noteDurSync));
+            }
+
+            playHead.sampleRate = setup.sampleRate;
+            processor.setPlayHead (&playHead);
+            processor.setRateAndBufferSizeDetails (setup.sampleRate, setup.blockSize);
+            processor.prepareToPlay (setup.sampleRate, setup.blockSize);
+
+            buffer.setSize (2, setup.blockSize);
+
+            for (int i = 0; i < setup.numNotes; ++i)
+                midi.addEvent (juce::MidiMessage::noteOn (1, 48 + i * 2, 0.8f), 0);
+
+            // Run for a second so the voices and release tails are at their steady state
+            for (int i = 0; i < static_cast<int> (setup.sampleRate) / setup.blockSize; ++i)
+                processBlock();
+        }
+
+        void processBlock()
+        {
+            processor.processBlock (buffer, midi);
+            playHead.position += setup.blockSize;
+
+            // The notes stay held, only the first block carries their note-ons
+            midi.clear();
+        }
+
+        const ProcessBlockSetup setup;
+        juce::AudioBuffer<float> buffer;
+
+    private:
+        void setParameter (const juce::String& paramID, float value)
+        {
+            auto* param = processor.getState().getParameter (paramID);
+            param->setValueNotifyingHost (param->convertTo0to1 (value));
+        }
+
+        PluginProcessor processor;
+        BenchmarkPlayHead playHead;
+        juce::MidiBuffer midi;
+    };
+
+    /** Benchmarks one block of a setup, then reports its throughput and worst-case block time over ten seconds of audio. */
+    void benchmarkProcessBlock (const juce::String& name, const ProcessBlockSetup& setup)
+    {
+        ProcessBlockRig rig (setup);
+
+        BENCHMARK (name.toStdString())
+        {
+            rig.processBlock();
+            return rig.buffer.getSample (0, 0);
+        };
+
+        // Catch reports the mean block, the worst case is what causes dropouts
+        const int numBlocks = static_cast<int> (10.0 * setup.sampleRate) / setup.blockSize;
+        double totalSeconds = 0.0, worstSeconds = 0.0;
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            rig.processBlock();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            totalSeconds += elapsed.count();
+            worstSeconds = juce::jmax (worstSeconds, elapsed.count());
+        }
+
+        const double blockBudget = setup.blockSize / setup.sampleRate;
+
+        std::cout << name << ": " << juce::String (numBlocks * setup.blockSize / totalSeconds / 1.0e6, 2) << " M samples/s, "
+                  << "worst block " << juce::String (worstSeconds * 1.0e6, 1) << " us ("
+                  << juce::String (100.0 * worstSeconds / blockBudget, 1) << "% of its real-time budget)" << std::endl;
+    }
+}
+
+TEST_CASE ("processBlock block sizes", "[processBlock]")
+{
+    for (int blockSize : { 32, 64, 128, 256, 512, 1024, 2048, 4096 })
+    {
+        ProcessBlockSetup setup;
+        setup.blockSize = blockSize;
+        benchmarkProcessBlock ("Block size " + juce::String (blockSize), setup);
+    }
+}
+
+TEST_CASE ("processBlock sample rates", "[processBlock]")
+{
+    for (double sampleRate : { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 })
+    {
+        ProcessBlockSetup setup;
+        setup.sampleRate = sampleRate;
+        benchmarkProcessBlock ("Sample rate " + juce::String (sampleRate / 1000.0, 1) + " kHz", setup);
+    }
+}
+
+TEST_CASE ("processBlock oscillators", "[processBlock]")
+{
+    const juce::StringArray names { "Sine", "Triangle", "Saw", "Square" };
+
+    for (int waveform = 0; waveform < names.size(); ++waveform)
+    {
+        ProcessBlockSetup setup;
+        setup.waveform = waveform;
+        benchmarkProcessBlock (names[waveform] + " oscillator", setup);
+    }
+}
+
+TEST_CASE ("processBlock voice counts", "[processBlock]")
+{
+    // Chords on up to four lanes with release tails overlapping the next steps
+    for (auto [numNotes, numLanes] : std::vector<std::pair<int, int>> { { 1, 1 }, { 4, 2 }, { 8, 4 }, { 16, 4 }, { 32, 4 } })
+    {
+        ProcessBlockSetup setup;
+        setup.numNotes = numNotes;
+        setup.numLanes = numLanes;
+        setup.polyphony = SynthEngine::maxPolyphony;
+        setup.noteDur = 0.05f;
+        setup.release = 0.1f;
+        benchmarkProcessBlock (juce::String (numNotes * numLanes) + " notes per step", setup);
+    }
+}
+
+TEST_CASE ("processBlock arp rates", "[processBlock]")
+{
+    for (float noteDur : { 0.001f, 0.01f, 0.1f, 1.0f })
+    {
+        ProcessBlockSetup setup;
+        setup.noteDur = noteDur;
+        benchmarkProcessBlock ("Free-running " + juce::String (noteDur * 1000.0f) + " ms steps", setup);
+    }
+
+    // Synced to the fake playhead at 120 BPM, 1/128 notes are 15.6 ms
+    for (int noteDurSync : { 0, 3, 5 })
+    {
+        ProcessBlockSetup setup;
+        setup.sync = true;
+        setup.noteDurSync = noteDurSync;
+        benchmarkProcessBlock ("Synced 1/" + juce::String (128 >> noteDurSync) + " notes", setup);
+    }
+}
+
+TEST_CASE ("processBlock held chord vs silence", "[processBlock]")
+{
+    ProcessBlockSetup chord;
+    chord.numNotes = 8;
+    chord.numLanes = 4;
+    benchmarkProcessBlock ("Full chords held", chord);
+
+    ProcessBlockSetup silence;
+    silence.numNotes = 0;
+    benchmarkProcessBlock ("Silence", silence);
+}
@@ -0,0 +1,192 @@
+#include "BatchRenderer.h"
+
+#include <map>
+#include <set>
+#include <thread>
+
+BatchRenderer::BatchRenderer (const RenderSettings& renderSettings, const juce::MemoryBlock& state, int threads, int maxQueuedBlocks)
+    : settings (renderSettings),
+      baseState (state),
+      numThreads (juce::jmax (1, threads))
+{
+    // At least one buffer per worker, so each can always have a block in flight
+    buffers.resize ((size_t) juce::jmax (maxQueuedBlocks, numThreads));
+
+    for (int i = 0; i < (int) buffers.size(); ++i)
+        freeBuffers.push_back (i);
+}
+
+juce::Result BatchRenderer::run (const std::vector<BatchJob>& jobs)
+{
+    // The processors are created here on the message thread, each worker then reuses its own for all its jobs
+    std::vector<std::unique_ptr<OfflineRenderer>> renderers;
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        renderers.push_back (std::make_unique<OfflineRenderer> (settings));
+
+        if (auto result = renderers.back()->prepare(); result.failed())
+            return result;
+    }
+
+    nextJob = 0;
+    errors.clear();
+
+    std::thread writer ([this, &jobs] { writeBlocks (jobs); });
+    std::vector<std::thread> workers;
+
+    for (auto& renderer : renderers)
+        workers.emplace_back ([this, &jobs, &renderer] { renderJobs (*renderer, jobs); });
+
+    for (auto& worker : workers)
+        worker.join();
+
+    writer.join();
+
+    return errors.isEmpty() ? juce::Result::ok() : juce::Result::fail (errors[0]);
+}
+
+//==============================================================================
+void BatchRenderer::renderJobs (OfflineRenderer& renderer, const std::vector<BatchJob>& jobs)
+{
+    for (int job = nextJob++; job < (int) jobs.size(); job = nextJob++)
+    {
+        const auto& batchJob = jobs[(size_t) job];
+
+        // Start from the base state so nothing carries over from the worker's previous job
+        renderer.setState (baseState);
+        auto result = juce::Result::ok();
+
+        if (batchJob.stateFile != juce::File())
+            result = renderer.loadState (batchJob.stateFile);
+
+        for (const auto& [paramID, value] : batchJob.parameters)
+            if (result.wasOk())
+                result = renderer.setParameter (paramID, value);
+
+        renderer.restart();
+
+        // Jobs that can't be set up still get their end marker, so the writer knows they are done
+        if (result.failed())
+            addError (batchJob.outputFile.getFileName() + ": " + result.getErrorMessage());
+
+        while (result.wasOk())
+        {
+            auto bufferIndex = acquireBuffer();
+            auto& buffer = buffers[(size_t) bufferIndex];
+            buffer.setSize (renderer.getNumChannels(), renderer.getBlockSize(), false, false, true);
+
+            auto numSamples = renderer.renderNextBlock (buffer);
+
+            if (numSamples == 0)
+            {
+                releaseBuffer (bufferIndex);
+                break;
+            }
+
+            pushBlock ({ job, bufferIndex, numSamples });
+        }
+
+        pushBlock ({ job, -1, 0 });
+    }
+}
+
+void BatchRenderer::writeBlocks (const std::vector<BatchJob>& jobs)
+{
+    juce::WavAudioFormat wav;
+
+    // Open writers of the jobs in flight, at most one per worker
+    std::map<int, std::unique_ptr<juce::AudioFormatWriter>> writers;
+    std::set<int> failedJobs;
+
+    for (size_t jobsDone = 0; jobsDone < jobs.size();)
+    {
+        auto block = popBlock();
+
+        if (block.bufferIndex < 0)
+        {
+            writers.erase (block.job); // closes the file
+            ++jobsDone;
+            continue;
+        }
+
+        const auto& buffer = buffers[(size_t) block.bufferIndex];
+        auto& writer = writers[block.job];
+
+        if (writer == nullptr && failedJobs.count (block.job) == 0)
+        {
+            const auto& file = jobs[(size_t) block.job].outputFile;
+            file.deleteFile();
+            std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+
+            if (stream != nullptr)
+                writer.reset (wav.createWriterFor (stream.get(), settings.sampleRate, static_cast<unsigned int> (buffer.getNumChannels()), 24, {}, 0));
+
+            if (writer != nullptr)
+            {
+                stream.release(); // the writer owns it now
+            }
+            else
+            {
+                addError ("Can't write to " + file.getFullPathName());
+                failedJobs.insert (block.job);
+            }
+        }
+
+        if (writer != nullptr && ! writer->writeFromAudioSampleBuffer (buffer, 0, block.numSamples))
+        {
+            addError ("Writing " + jobs[(size_t) block.job].outputFile.getFullPathName() + " failed");
+            failedJobs.insert (block.job);
+            writer.reset();
+        }
+
+        releaseBuffer (block.bufferIndex);
+    }
+}
+
+//==============================================================================
+int BatchRenderer::acquireBuffer()
+{
+    std::unique_lock<std::mutex> scopedLock (lock);
+    bufferFreed.wait (scopedLock, [this] { return ! freeBuffers.empty(); });
+
+    auto bufferIndex = freeBuffers.back();
+    freeBuffers.pop_back();
+    return bufferIndex;
+}
+
+void BatchRenderer::releaseBuffer (int bufferIndex)
+{
+    {
+        std::lock_guard<std::mutex> scopedLock (lock);
+        freeBuffers.push_back (bufferIndex);
+    }
+
+    bufferFreed.notify_one();
+}
+
+void BatchRenderer::pushBlock (const Block& block)
+{
+    {
+        std::lock_guard<std::mutex> scopedLock (lock);
+        queue.push_back (block);
+    }
+
+    blockQueued.notify_one();
+}
+
+BatchRenderer::Block BatchRenderer::popBlock()
+{
+    std::unique_lock<std::mutex> scopedLock (lock);
+    blockQueued.wait (scopedLock, [this] { return ! queue.empty(); });
+
+    auto block = queue.front();
+    queue.pop_front();
+    return block;
+}
+
+void BatchRenderer::addError (const juce::String& error)
+{
+    std::lock_guard<std::mutex> scopedLock (errorLock);
+    errors.add (error);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "OfflineRenderer.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+//==============================================================================
+/** One clip of a batch: a state file and/or parameter values on top of the batch's base state. */
+struct BatchJob
+{
+    juce::File stateFile; // none keeps the base state
+    std::vector<std::pair<juce::String, float>> parameters; // paramID and value in the parameter's own units
+    juce::File outputFile;
+};
+
+//==============================================================================
+/**
+Renders many jobs with the same MIDI file across a pool of worker threads.
+
+Each worker owns one OfflineRenderer (and so one PluginProcessor) for the
+whole batch. The renderers are created on the calling thread, which must be
+the message thread. Before every job it restores the base state, applies the job's
+state file and parameters, and rewinds. Workers take the next job from a
+shared counter as soon as they finish one, so uneven jobs still keep every
+core busy.
+
+Rendered blocks go through a bounded queue to a single writer thread that
+streams them into the jobs' WAV files. The blocks live in a fixed pool of
+buffers that workers wait for when the writer falls behind, so memory use
+doesn't grow with the number of jobs.
+*/
+class BatchRenderer
+{
+public:
+    /** numThreads workers share a pool of maxQueuedBlocks buffers. */
+    BatchRenderer (const RenderSettings& settings, const juce::MemoryBlock& baseState, int numThreads, int maxQueuedBlocks);
+
+    /** Renders every job, blocking until they are all written. Returns the first error, if any job failed. */
+    juce::Result run (const std::vector<BatchJob>& jobs);
+
+private:
+    // A rendered block waiting for the writer, bufferIndex -1 marks the end of a job
+    struct Block
+    {
+        int job = 0;
+        int bufferIndex = -1;
+        int numSamples = 0;
+    };
+
+    void renderJobs (OfflineRenderer& renderer, const std::vector<BatchJob>& jobs);
+    void writeBlocks (const std::vector<BatchJob>& jobs);
+
+    int acquireBuffer();
+    void releaseBuffer (int bufferIndex);
+    void pushBlock (const Block& block);
+    Block popBlock();
+
+    void addError (const juce::String& error);
+
+    RenderSettings settings;
+    juce::MemoryBlock baseState;
+    int numThreads;
+
+    std::atomic<int> nextJob { 0 };
+
+    // Buffer pool and the queue of blocks for the writer, guarded by lock
+    std::vector<juce::AudioBuffer<float>> buffers;
+    std::vector<int> freeBuffers;
+    std::deque<Block> queue;
+    std::mutex lock;
+    std::condition_variable bufferFreed;
+    std::condition_variable blockQueued;
+
+    juce::StringArray errors;
+    std::mutex errorLock;
+
+    JUCE_DECLARE_NON_COPYABLE (BatchRenderer)
+};
@@ -0,0 +1,261 @@
+#include "BatchRenderer.h"
+
+#include <iostream>
+
+namespace
+{
+    const char* usage = "Usage: RARPRender <input.mid> <output.wav> [options]\n"
+                        "       RARPRender --batch <input.mid> <output folder> [--states <list file>] [--sweep <paramID>=<v1>,<v2>,...]... [--threads <n>] [--queue <blocks>] [options]\n"
+                        "Options: [--state <file>] [--bpm <n>] [--rate <hz>] [--block <samples>] [--tail <seconds>]";
+
+    /** Renders everything the renderer produces into a 24-bit WAV file. */
+    juce::Result writeWav (OfflineRenderer& renderer, const juce::File& outputFile)
+    {
+        outputFile.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream (outputFile.createOutputStream());
+
+        if (stream == nullptr)
+            return juce::Result::fail ("Can't write to " + outputFile.getFullPathName());
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(),
+            renderer.getSampleRate(),
+            static_cast<unsigned int> (renderer.getNumChannels()),
+            24,
+            {},
+            0));
+
+        if (writer == nullptr)
+            return juce::Result::fail ("Can't create a WAV writer for " + outputFile.getFullPathName());
+
+        stream.release(); // the writer owns it now
+
+        juce::AudioBuffer<float> buffer (renderer.getNumChannels(), renderer.getBlockSize());
+
+        while (auto numSamples = renderer.renderNextBlock (buffer))
+            if (! writer->writeFromAudioSampleBuffer (buffer, 0, numSamples))
+                return juce::Result::fail ("Writing " + outputFile.getFullPathName() + " failed");
+
+        return juce::Result::ok();
+    }
+
+    /** Builds one job per combination of state file and swept parameter values, and lists them in index.csv. */
+    juce::Result makeBatchJobs (const juce::StringArray& stateFiles,
+        const std::vector<std::pair<juce::String, std::vector<float>>>& sweeps,
+        const juce::File& outputFolder,
+        std::vector<BatchJob>& jobs)
+    {
+        size_t numCombinations = 1;
+
+        for (const auto& sweep : sweeps)
+            numCombinations *= sweep.second.size();
+
+        const auto numJobs = juce::jmax (1, stateFiles.size()) * numCombinations;
+        const auto digits = juce::String (numJobs).length();
+
+        juce::String index ("file,state");
+
+        for (const auto& sweep : sweeps)
+            index << "," << sweep.first;
+
+        index << "\n";
+
+        for (size_t i = 0; i < numJobs; ++i)
+        {
+            BatchJob job;
+            juce::String name (juce::String (i).paddedLeft ('0', digits));
+            juce::String row;
+
+            if (! stateFiles.isEmpty())
+            {
+                job.stateFile = juce::File::getCurrentWorkingDirectory().getChildFile (stateFiles[(int) (i / numCombinations)]);
+
+                if (! job.stateFile.existsAsFile())
+                    return juce::Result::fail ("Can't find the state file " + job.stateFile.getFullPathName());
+
+                name << "_" << job.stateFile.getFileNameWithoutExtension();
+                row << job.stateFile.getFullPathName();
+            }
+
+            // The last sweep changes fastest
+            auto combination = i % numCombinations;
+
+            for (auto sweep = sweeps.rbegin(); sweep != sweeps.rend(); ++sweep)
+            {
+                auto value = sweep->second[combination % sweep->second.size()];
+                combination /= sweep->second.size();
+
+                job.parameters.insert (job.parameters.begin(), { sweep->first, value });
+            }
+
+            for (const auto& [paramID, value] : job.parameters)
+            {
+                name << "_" << paramID << "-" << juce::String (value);
+                row << "," << juce::String (value);
+            }
+
+            job.outputFile = outputFolder.getChildFile (name + ".wav");
+            index << job.outputFile.getFileName() << "," << row << "\n";
+            jobs.push_back (std::move (job));
+        }
+
+        if (! outputFolder.getChildFile ("index.csv").replaceWithText (index))
+            return juce::Result::fail ("Can't write to " + outputFolder.getFullPathName());
+
+        return juce::Result::ok();
+    }
+
+    /** Renders a batch of jobs into outputFolder on numThreads workers. */
+    int runBatch (juce::ArgumentList& args, const RenderSettings& settings)
+    {
+        juce::StringArray stateFiles;
+
+        if (auto listFile = args.removeValueForOption ("--states"); listFile.isNotEmpty())
+        {
+            auto file = juce::File::getCurrentWorkingDirectory().getChildFile (listFile);
+
+            if (! file.existsAsFile())
+            {
+                std::cerr << "Can't find the state list " << file.getFullPathName() << std::endl;
+                return 1;
+            }
+
+            file.readLines (stateFiles);
+            stateFiles.trim();
+            stateFiles.removeEmptyStrings();
+        }
+
+        // Every --sweep paramID=v1,v2,... adds a dimension to the grid
+        std::vector<std::pair<juce::String, std::vector<float>>> sweeps;
+
+        for (auto sweep = args.removeValueForOption ("--sweep"); sweep.isNotEmpty(); sweep = args.removeValueForOption ("--sweep"))
+        {
+            std::vector<float> values;
+
+            for (const auto& value : juce::StringArray::fromTokens (sweep.fromFirstOccurrenceOf ("=", false, false), ",", {}))
+                values.push_back (value.getFloatValue());
+
+            if (values.empty())
+            {
+                std::cerr << "--sweep needs values, as in noteDur=0.1,0.2" << std::endl;
+                return 1;
+            }
+
+            sweeps.push_back ({ sweep.upToFirstOccurrenceOf ("=", false, false), values });
+        }
+
+        const auto numThreads = args.containsOption ("--threads") ? args.removeValueForOption ("--threads").getIntValue() : juce::SystemStats::getNumCpus();
+        const auto maxQueuedBlocks = args.containsOption ("--queue") ? args.removeValueForOption ("--queue").getIntValue() : numThreads * 4;
+
+        if (args.size() != 2)
+        {
+            std::cerr << usage << std::endl;
+            return 1;
+        }
+
+        auto batchSettings = settings;
+        batchSettings.midiFile = args[0].resolveAsFile();
+        const auto outputFolder = args[1].resolveAsFile();
+
+        // Every job starts from the same base state, which also fixes the arp's seed across workers
+        juce::MemoryBlock baseState;
+        {
+            OfflineRenderer base (batchSettings);
+            auto result = base.prepare();
+
+            if (result.wasOk())
+                base.getState (baseState);
+
+            // Catch misspelt parameter IDs before any rendering starts
+            for (const auto& sweep : sweeps)
+                if (result.wasOk())
+                    result = base.setParameter (sweep.first, sweep.second.front());
+
+            if (result.failed())
+            {
+                std::cerr << result.getErrorMessage() << std::endl;
+                return 1;
+            }
+        }
+
+        std::vector<BatchJob> jobs;
+        auto result = outputFolder.createDirectory();
+
+        if (result.wasOk())
+            result = makeBatchJobs (stateFiles, sweeps, outputFolder, jobs);
+
+        auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        if (result.wasOk())
+            result = BatchRenderer (batchSettings, baseState, numThreads, maxQueuedBlocks).run (jobs);
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        auto renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        std::cout << "Rendered " << jobs.size() << " files to " << outputFolder.getFullPathName()
+                  << " in " << renderSeconds << " s on " << numThreads << " threads" << std::endl;
+
+        return 0;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    // The processor's APVTS expects a message manager
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    juce::ArgumentList args (argc, argv);
+    RenderSettings settings;
+
+    auto option = [&] (const char* name, double defaultValue) {
+        auto value = args.removeValueForOption (name);
+        return value.isEmpty() ? defaultValue : value.getDoubleValue();
+    };
+
+    if (auto stateFile = args.removeValueForOption ("--state"); stateFile.isNotEmpty())
+        settings.stateFile = juce::File::getCurrentWorkingDirectory().getChildFile (stateFile);
+
+    settings.bpm = option ("--bpm", settings.bpm);
+    settings.sampleRate = option ("--rate", settings.sampleRate);
+    settings.blockSize = static_cast<int> (option ("--block", settings.blockSize));
+    settings.tailSeconds = option ("--tail", settings.tailSeconds);
+
+    if (args.removeOptionIfFound ("--batch"))
+        return runBatch (args, settings);
+
+    if (args.size() != 2)
+    {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+
+    settings.midiFile = args[0].resolveAsFile();
+    const auto outputFile = args[1].resolveAsFile();
+
+    OfflineRenderer renderer (settings);
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto result = renderer.prepare();
+
+    if (result.wasOk())
+        result = writeWav (renderer, outputFile);
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    auto renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    auto audioSeconds = static_cast<double> (renderer.getLengthInSamples()) / renderer.getSampleRate();
+
+    std::cout << "Rendered " << audioSeconds << " s to " << outputFile.getFullPathName()
+              << " in " << renderSeconds << " s (" << audioSeconds / juce::jmax (renderSeconds, 0.001) << "x real time)" << std::endl;
+
+    return 0;
+}
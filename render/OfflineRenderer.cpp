@@ -0,0 +1,167 @@
+#include "OfflineRenderer.h"
+
+OfflineRenderer::OfflineRenderer (const RenderSettings& renderSettings)
+    : settings (renderSettings)
+{
+}
+
+juce::Result OfflineRenderer::prepare()
+{
+    if (settings.sampleRate <= 0.0 || settings.blockSize <= 0)
+        return juce::Result::fail ("The sample rate and block size must be positive");
+
+    if (settings.stateFile != juce::File())
+        if (auto result = loadState (settings.stateFile); result.failed())
+            return result;
+
+    if (auto result = loadMidi(); result.failed())
+        return result;
+
+    processor.setPlayHead (&playHead);
+    processor.setNonRealtime (true);
+    processor.setRateAndBufferSizeDetails (settings.sampleRate, settings.blockSize);
+
+    midi.ensureSize ((size_t) events.getNumEvents() * 8);
+
+    playHead.info.setBpm (settings.bpm);
+    playHead.info.setTimeSignature (juce::AudioPlayHead::TimeSignature {});
+    playHead.info.setIsPlaying (true);
+
+    restart();
+    return juce::Result::ok();
+}
+
+void OfflineRenderer::setState (const juce::MemoryBlock& state)
+{
+    processor.setStateInformation (state.getData(), static_cast<int> (state.getSize()));
+}
+
+juce::Result OfflineRenderer::loadState (const juce::File& file)
+{
+    juce::MemoryBlock state;
+
+    if (! file.loadFileAsData (state))
+        return juce::Result::fail ("Can't read the state file " + file.getFullPathName());
+
+    setState (state);
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::setParameter (const juce::String& paramID, float value)
+{
+    auto* param = processor.getState().getParameter (paramID);
+
+    if (param == nullptr)
+        return juce::Result::fail ("There is no parameter called " + paramID);
+
+    param->setValueNotifyingHost (param->convertTo0to1 (value));
+    return juce::Result::ok();
+}
+
+void OfflineRenderer::restart()
+{
+    position = 0;
+    nextEvent = 0;
+
+    processor.getMidiKeyboardState().reset();
+    processor.prepareToPlay (settings.sampleRate, settings.blockSize);
+}
+
+int OfflineRenderer::getNumChannels() const
+{
+    return juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+}
+
+//==============================================================================
+int OfflineRenderer::renderNextBlock (juce::AudioBuffer<float>& buffer)
+{
+    jassert (buffer.getNumChannels() >= getNumChannels() && buffer.getNumSamples() == settings.blockSize);
+
+    if (position >= lengthInSamples)
+        return 0;
+
+    const auto blockEnd = position + settings.blockSize;
+
+    // Every event that falls inside this block, at its offset from the block start
+    midi.clear();
+
+    for (; nextEvent < events.getNumEvents(); ++nextEvent)
+    {
+        const auto* event = events.getEventPointer (nextEvent);
+        const auto sample = static_cast<juce::int64> (event->message.getTimeStamp());
+
+        if (sample >= blockEnd)
+            break;
+
+        midi.addEvent (event->message, static_cast<int> (sample - position));
+    }
+
+    // The playhead reports where this block starts on the song's timeline
+    const double seconds = static_cast<double> (position) / settings.sampleRate;
+    const double ppq = seconds * settings.bpm / 60.0;
+
+    playHead.info.setTimeInSamples (position);
+    playHead.info.setTimeInSeconds (seconds);
+    playHead.info.setPpqPosition (ppq);
+    playHead.info.setPpqPositionOfLastBarStart (std::floor (ppq / 4.0) * 4.0);
+
+    processor.processBlock (buffer, midi);
+
+    const auto numSamples = static_cast<int> (juce::jmin (static_cast<juce::int64> (settings.blockSize), lengthInSamples - position));
+    position = blockEnd;
+
+    return numSamples;
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::loadMidi()
+{
+    juce::FileInputStream stream (settings.midiFile);
+
+    if (! stream.openedOk())
+        return juce::Result::fail ("Can't open the MIDI file " + settings.midiFile.getFullPathName());
+
+    juce::MidiFile midiFile;
+
+    if (! midiFile.readFrom (stream))
+        return juce::Result::fail (settings.midiFile.getFullPathName() + " isn't a Standard MIDI File");
+
+    const auto ticksPerQuarter = midiFile.getTimeFormat();
+
+    if (ticksPerQuarter <= 0)
+        return juce::Result::fail ("SMPTE timed MIDI files aren't supported");
+
+    // The whole file plays at one tempo, so the playhead's PPQ and the event times agree
+    if (settings.bpm <= 0.0)
+    {
+        juce::MidiMessageSequence tempoEvents;
+        midiFile.findAllTempoEvents (tempoEvents);
+
+        settings.bpm = tempoEvents.getNumEvents() > 0
+                           ? 60.0 / tempoEvents.getEventPointer (0)->message.getTempoSecondsPerQuarterNote()
+                           : 120.0;
+    }
+
+    const double samplesPerTick = 60.0 / settings.bpm * settings.sampleRate / ticksPerQuarter;
+
+    // Merge every track's channel messages onto one timeline in samples
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+    {
+        for (const auto* event : *midiFile.getTrack (track))
+        {
+            if (event->message.isMetaEvent() || event->message.isSysEx())
+                continue;
+
+            auto message = event->message;
+            message.setTimeStamp (std::round (message.getTimeStamp() * samplesPerTick));
+            events.addEvent (message);
+        }
+    }
+
+    events.sort();
+
+    const auto lastEvent = events.getNumEvents() > 0 ? static_cast<juce::int64> (events.getEndTime()) : 0;
+    lengthInSamples = lastEvent + static_cast<juce::int64> (settings.tailSeconds * settings.sampleRate);
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <PluginProcessor.h>
+
+//==============================================================================
+/** What to render: a MIDI file played through a saved plugin state. */
+struct RenderSettings
+{
+    juce::File midiFile;
+    juce::File stateFile; // a getStateInformation() blob, or none for the default patch
+    double sampleRate = 48000.0;
+    int blockSize = 4096;
+    double bpm = 0.0; // 0 takes the MIDI file's first tempo, or 120 if it has none
+    double tailSeconds = 2.0; // rendered after the last MIDI event so releases ring out
+};
+
+//==============================================================================
+/**
+Drives a PluginProcessor from a Standard MIDI File without an audio device.
+
+The MIDI file's events are placed on a constant-tempo timeline and a
+simulated playhead reports that tempo and the PPQ position of every block,
+so a synced arp runs exactly as it would in a host that is playing. Blocks
+are rendered back to back as fast as the processor allows; no editor is
+created, so the waveform display's feed stays off.
+*/
+class OfflineRenderer
+{
+public:
+    explicit OfflineRenderer (const RenderSettings& settings);
+
+    /** Loads the plugin state and MIDI file and prepares the processor. Call once before rendering. */
+    juce::Result prepare();
+
+    /** Replaces the plugin state with a getStateInformation() blob. */
+    void setState (const juce::MemoryBlock& state);
+
+    /** Writes the current plugin state to a getStateInformation() blob. */
+    void getState (juce::MemoryBlock& state) { processor.getStateInformation (state); }
+
+    /** Replaces the plugin state with the blob in a file. */
+    juce::Result loadState (const juce::File& file);
+
+    /** Sets a parameter to a value in its own units (seconds, levels, choice indices...). */
+    juce::Result setParameter (const juce::String& paramID, float value);
+
+    /** Rewinds to the start of the MIDI file with the processor's voices and arp cleared, so the renderer can be reused. */
+    void restart();
+
+    /** Renders the next block into buffer, which needs getNumChannels() channels of getBlockSize() samples.
+
+    Returns how many of the block's samples belong to the render, 0 once it is complete.
+    */
+    int renderNextBlock (juce::AudioBuffer<float>& buffer);
+
+    int getNumChannels() const;
+    int getBlockSize() const noexcept { return settings.blockSize; }
+    double getSampleRate() const noexcept { return settings.sampleRate; }
+
+    /** Returns the length of the render, from the start of the MIDI file to the end of the tail. */
+    juce::int64 getLengthInSamples() const noexcept { return lengthInSamples; }
+
+private:
+    juce::Result loadMidi();
+
+    class PlayHead : public juce::AudioPlayHead
+    {
+    public:
+        juce::Optional<PositionInfo> getPosition() const override { return info; }
+
+        PositionInfo info;
+    };
+
+    RenderSettings settings;
+
+    PluginProcessor processor;
+    PlayHead playHead;
+
+    juce::MidiMessageSequence events; // timestamps in samples
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+
+    juce::int64 position = 0;
+    juce::int64 lengthInSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (OfflineRenderer)
+};
@@ -1,44 +1,35 @@
 #pragma once
 
+#include "Envelope.h"
+
 // Modified version of JUCE's ADSR envelope class
 
 //==============================================================================
 /**
-A very simple ADSR envelope class.
+A DAHDSR envelope: delay, attack, hold, decay, sustain and release.
 
 To use it, call setSampleRate() with the current sample rate and give it some parameters
 with setParameters() then call getNextSample() to get the envelope value to be applied
 to each audio sample or applyEnvelopeToBuffer() to apply the envelope to a whole buffer.
 
-Do not change the parameters during playback. If you change the parameters before the
-release stage has completed then you must call reset() before the next call to
-noteOn().
+The stages run on an Envelope: setParameters() turns them into a fixed list of
+segments (delay, attack, hold, decay | release) with the sustain point after the
+decay. With loop on, attack to decay repeat while the note is held. With delay
+and hold at 0 the shape is exactly the classic ADSR.
 
 @tags{Audio}
 */
 class ADSR
 {
 public:
-    //==============================================================================
-    ADSR()
-    {
-        //recalculateRates();
-    }
+    ADSR() { setParameters (parameters); }
 
     //==============================================================================
-    
-    /**
-    Static function that maps domain [0, 1] -> range [0, 1] using an exponential curve
-    (used in getNextSample())
+    /** Maps domain [0, 1] -> range [0, 1] using the exponential curve of the attack (ascending), decay and release stages.
 
+    @see Envelope::curve
     */
-    static float curve (float x, float expo, bool ascending)
-    {
-        if (ascending == true)
-            return (std::exp (expo * x) - 1) / (std::exp (expo) - 1);
-        else
-            return (std::exp (-1 * expo * (x - 1)) - 1) / (std::exp (expo) - 1);
-    }
+    static float curve (float x, float expo, bool ascending) { return Envelope::curve (x, expo, ascending); }
 
     //==============================================================================
     /**
@@ -65,6 +56,8 @@ public:
         }
 
         float attack = 0.1f, decay = 0.1f, sustain = 1.0f, release = 0.1f, expo = 0.1f;
+        float delay = 0.0f, hold = 0.0f;
+        bool loop = false;
     };
 
     /** Sets the parameters that will be used by an ADSR object.
@@ -76,11 +69,17 @@ public:
     */
     void setParameters (const Parameters& newParameters)
     {
-        // need to call setSampleRate() first!
-        jassert (sampleRate > 0.0);
-
         parameters = newParameters;
-        //recalculateRates();
+
+        const Envelope::Segment segments[] = {
+            { parameters.delay, 0.0f, parameters.expo },
+            { parameters.attack, 1.0f, parameters.expo },
+            { parameters.hold, 1.0f, parameters.expo },
+            { parameters.decay, parameters.sustain, parameters.expo },
+            { parameters.release, 0.0f, parameters.expo }
+        };
+
+        envelope.setSegments (segments, numSegments, sustainPoint, parameters.loop ? attackSegment : -1, parameters.loop ? decaySegment : -1);
     }
 
     /** Returns the parameters currently being used by an ADSR object.
@@ -89,137 +88,38 @@ public:
     */
     const Parameters& getParameters() const noexcept { return parameters; }
 
-    /** Returns true if the envelope is in its attack, decay, sustain or release stage. */
-    bool isActive() const noexcept { return state != State::idle; }
+    /** Returns true if the envelope is in its delay, attack, hold, decay, sustain or release stage. */
+    bool isActive() const noexcept { return envelope.isActive(); }
+
+    /** Returns true if the envelope is in its release stage. */
+    bool isReleasing() const noexcept { return envelope.isReleasing(); }
+
+    /** Returns the last envelope value that was generated. */
+    float getCurrentValue() const noexcept { return envelope.getCurrentValue(); }
 
     //==============================================================================
     /** Sets the sample rate that will be used for the envelope.
 
     This must be called before the getNextSample() or setParameters() methods.
     */
-    void setSampleRate (double newSampleRate) noexcept
-    {
-        jassert (newSampleRate > 0.0);
-        sampleRate = newSampleRate;
-    }
+    void setSampleRate (double newSampleRate) noexcept { envelope.setSampleRate (newSampleRate); }
 
     //==============================================================================
     /** Resets the envelope to an idle state. */
-    void reset() noexcept
-    {
-        envelopeVal = 0.0f;
-        numSamples = 0;
-        releaseVal = 0.0f;
-        state = State::idle;
-    }
+    void reset() noexcept { envelope.reset(); }
 
-    /** Starts the attack phase of the envelope. */
-    void noteOn() noexcept
-    {
-        if (parameters.attack > 0.0f)
-        {
-            numSamples = parameters.attack * sampleRate;
-            state = State::attack;
-        }
-        else if (parameters.decay > 0.0f)
-        {
-            //envelopeVal = 1.0f;
-            numSamples = parameters.decay * sampleRate;
-            state = State::decay;
-        }
-        else
-        {
-            numSamples = 0;
-            //envelopeVal = parameters.sustain;
-            state = State::sustain;
-        }
-    }
+    /** Starts the delay (or attack) phase of the envelope. */
+    void noteOn() noexcept { envelope.noteOn(); }
 
     /** Starts the release phase of the envelope. */
-    void noteOff() noexcept
-    {
-        if (state != State::idle)
-        {
-            if (parameters.release > 0.0f)
-            {
-                //releaseRate = (float) (envelopeVal / (parameters.release * sampleRate));
-                sampleDelta = 0;
-                releaseVal = envelopeVal;
-                numSamples = parameters.release * sampleRate;
-                state = State::release;
-            }
-            else
-            {
-                reset();
-            }
-        }
-    }
+    void noteOff() noexcept { envelope.noteOff(); }
 
     //==============================================================================
     /** Returns the next sample value for an ADSR object.
 
     @see applyEnvelopeToBuffer
     */
-    float getNextSample() noexcept
-    {
-        switch (state)
-        {
-            case State::idle:
-            {
-                return 0.0f;
-            }
-
-            case State::attack:
-            {
-                //envelopeVal += attackRate;
-                envelopeVal = curve (sampleDelta / numSamples, parameters.expo, true);
-
-                if (sampleDelta > numSamples)
-                {
-                    //envelopeVal = 1.0f;
-                    goToNextState();
-                }
-
-                break;
-            }
-
-            case State::decay:
-            {
-                //envelopeVal -= decayRate;
-                envelopeVal = curve (sampleDelta / numSamples, parameters.expo, false) * (1.0 - parameters.sustain) + parameters.sustain;
-
-                if (sampleDelta > numSamples)
-                {
-                    //envelopeVal = parameters.sustain;
-                    goToNextState();
-                }
-
-                break;
-            }
-
-            case State::sustain:
-            {
-                envelopeVal = parameters.sustain;
-                break;
-            }
-
-            case State::release:
-            {
-                //envelopeVal -= releaseRate;
-                envelopeVal = curve (sampleDelta / numSamples, parameters.expo, false) * releaseVal;
-
-                if (sampleDelta > numSamples)
-                {
-                    goToNextState();
-                }
-                break;
-            }
-        }
-
-        ++sampleDelta;
-
-        return envelopeVal;
-    }
+    float getNextSample() noexcept { return envelope.getNextSample(); }
 
     /** This method will conveniently apply the next numSamples number of envelope values
     to an AudioBuffer.
@@ -228,113 +128,23 @@ public:
     */
     void applyEnvelopeToBuffer (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
     {
-        jassert (startSample + numSamples <= buffer.getNumSamples());
-
-        if (state == State::idle)
-        {
-            buffer.clear (startSample, numSamples);
-            return;
-        }
-
-        if (state == State::sustain)
-        {
-            buffer.applyGain (startSample, numSamples, parameters.sustain);
-            return;
-        }
-
-        auto numChannels = buffer.getNumChannels();
-
-        while (--numSamples >= 0)
-        {
-            auto env = getNextSample();
-
-            for (int i = 0; i < numChannels; ++i)
-                buffer.getWritePointer (i)[startSample] *= env;
-
-            ++startSample;
-        }
-    }
-
-    void initialize (std::array<std::atomic<float>*, 5> adsrPtrs)
-    {
-        atomicParams = adsrPtrs;
+        envelope.applyEnvelopeToBuffer (buffer, startSample, numSamples);
     }
 
-    void updateADSR()
-    {
-        Parameters params;
-
-        params.attack = atomicParams[0]->load();
-        params.decay = atomicParams[1]->load();
-        params.sustain = atomicParams[2]->load();
-        params.release = atomicParams[3]->load();
-        params.expo = atomicParams[4]->load();
+    /** Writes the next numValues envelope values to dest, stride floats apart.
 
-        setParameters (params);
-    }
+    @see Envelope::renderEnvelope
+    */
+    void renderEnvelope (float* dest, int numValues, int stride) noexcept { envelope.renderEnvelope (dest, numValues, stride); }
 
 private:
     //==============================================================================
-    //void recalculateRates() noexcept
-    //{
-    //    auto getRate = [] (float distance, float timeInSeconds, double sr) {
-    //        return timeInSeconds > 0.0f ? (float) (distance / (timeInSeconds * sr)) : -1.0f;
-    //    };
-
-    //    attackRate = getRate (1.0f, parameters.attack, sampleRate);
-    //    decayRate = getRate (1.0f - parameters.sustain, parameters.decay, sampleRate);
-    //    releaseRate = getRate (parameters.sustain, parameters.release, sampleRate);
-
-    //    if ((state == State::attack && attackRate <= 0.0f)
-    //        || (state == State::decay && (decayRate <= 0.0f || envelopeVal <= parameters.sustain))
-    //        || (state == State::release && releaseRate <= 0.0f))
-    //    {
-    //        goToNextState();
-    //    }
-    //}
-
-    void goToNextState() noexcept
-    {
-        sampleDelta = 0;
-
-        if (state == State::attack)
-        {
-            numSamples = parameters.decay * sampleRate;
-            state = (parameters.decay > 0.0f ? State::decay : State::sustain);
-            return;
-        }
-
-        if (state == State::decay)
-        {
-            numSamples = 0;
-            state = State::sustain;
-            return;
-        }
+    // Layout of the segment list, the release follows the sustain point
+    static constexpr int attackSegment = 1;
+    static constexpr int decaySegment = 3;
+    static constexpr int sustainPoint = 4;
+    static constexpr int numSegments = 5;
 
-        if (state == State::release)
-            reset();
-    }
-
-    //==============================================================================
-    enum class State { idle,
-        attack,
-        decay,
-        sustain,
-        release };
-
-    State state = State::idle;
     Parameters parameters;
-    std::array<std::atomic<float>*, 5> atomicParams;
-
-    double sampleRate = 44100.0;
-    float envelopeVal = 0.0f;
-
-    // Variable to store envelope value at time of release
-    float releaseVal = 0.0f;
-
-    // Variables to keep track of which sample we are at in a state
-    int sampleDelta = 0;
-    double numSamples = 0;
-
-    //float attackRate = 0.0f, decayRate = 0.0f, releaseRate = 0.0f;
-};
\ No newline at end of file
+    Envelope envelope;
+};
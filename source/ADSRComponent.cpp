@@ -22,6 +22,11 @@ ADSRComponent::ADSRComponent(juce::AudioProcessorValueTreeState& state)
         // attachment
         attachments[i] = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (state, params[i], sliders[i]);
     }
+
+    // loop toggle
+    loopButton.setColour (juce::ToggleButton::textColourId, juce::Colours::white);
+    addAndMakeVisible (loopButton);
+    loopButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (state, "envLoop", loopButton);
 }
 
 //==============================================================================
@@ -37,9 +42,12 @@ void ADSRComponent::resized()
         const int width = getWidth();
         const int height = getHeight();
 
-        const int sliderSize = 130;
+        const int sliderSize = 100;
 
-        sliders[i].setBounds (i * width / 6.0f, 0, sliderSize, sliderSize);
-        labels[i].setBounds (i * width / 6.0f, -13, sliderSize, sliderSize);
+        sliders[i].setBounds (i * width / 8.0f, 0, sliderSize, sliderSize);
+        labels[i].setBounds (i * width / 8.0f, -13, sliderSize, sliderSize);
     }
+
+    // Under the attack knob, between delay and hold
+    loopButton.setBounds (sliders[1].getX() + 20, sliders[1].getBottom() + 5, 70, 24);
 }
\ No newline at end of file
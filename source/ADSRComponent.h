@@ -13,10 +13,14 @@ public:
     void resized() override;
 
 private:
-    std::array<juce::Slider, 5> sliders;
-    std::array<juce::Label, 5> labels;
-    std::array<std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>, 5> attachments;
-    std::array<std::string, 5> params { "attack", "decay", "sustain", "release", "expo" };
+    std::array<juce::Slider, 7> sliders;
+    std::array<juce::Label, 7> labels;
+    std::array<std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>, 7> attachments;
+    std::array<std::string, 7> params { "delay", "attack", "hold", "decay", "sustain", "release", "expo" };
+
+    // Repeats the attack, hold and decay stages while the note is held
+    juce::ToggleButton loopButton { "Loop" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> loopButtonAttachment;
 
     //std::array<std::atomic<float>*, 5> adsrAtomic;
 };
\ No newline at end of file
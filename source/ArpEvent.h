@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/** A note the arp starts or ends at a sample offset inside the current block. */
+struct ArpEvent
+{
+    enum class Type : uint8_t
+    {
+        noteOn,
+        noteOff
+    };
+
+    int offset = 0;
+    Type type = Type::noteOn;
+    uint8_t channel = 1; // 1-16, one per arp lane
+    uint8_t note = 0;
+    float pan = 0.0f; // from -1.0 (left) to 1.0 (right), note-ons only
+
+    bool isNoteOn() const noexcept { return type == Type::noteOn; }
+
+    juce::MidiMessage toMidiMessage() const
+    {
+        return isNoteOn() ? juce::MidiMessage::noteOn (channel, note, (juce::uint8) 127)
+                          : juce::MidiMessage::noteOff (channel, note);
+    }
+};
+
+//==============================================================================
+/**
+List of one block's ArpEvents, sorted by offset.
+
+Events are appended in offset order: the arp fills one list per lane, whose
+steps come in order anyway, and merge() combines them into the block's list.
+Events at one offset keep the order they were added in (a lane's note-offs
+before its next note-ons), and earlier lanes come first. The storage is
+allocated up front by prepare(), add() never allocates and drops events past
+the capacity. The arp keeps room for the note-off of every note it has
+started, so only note-ons can be dropped.
+*/
+class ArpEventList
+{
+public:
+    // Room for the events of a typical block, until prepare() sizes the list for the real settings
+    static constexpr int defaultCapacity = 4096;
+
+    ArpEventList() : events ((size_t) defaultCapacity) {}
+
+    /** Allocates room for maxEvents events and clears the list. Don't call on the audio thread. */
+    void prepare (int maxEvents)
+    {
+        events.assign ((size_t) juce::jmax (1, maxEvents), {});
+        numEvents = 0;
+    }
+
+    void clear() noexcept { numEvents = 0; }
+
+    /** Appends an event, which must not come before the last one added. */
+    void add (const ArpEvent& event) noexcept
+    {
+        jassert (numEvents < getCapacity());
+        jassert (numEvents == 0 || events[(size_t) numEvents - 1].offset <= event.offset);
+
+        if (numEvents < getCapacity())
+            events[(size_t) numEvents++] = event;
+    }
+
+    /** Replaces the contents with the events of numLists sorted lists, merged by offset.
+
+    Each output event is the earliest of the lists' next ones, ties going to the
+    earlier list, so this takes one pass over the events and numLists
+    comparisons for each.
+    */
+    void merge (const ArpEventList* lists, int numLists) noexcept
+    {
+        clear();
+
+        constexpr int maxLists = 16;
+        jassert (numLists <= maxLists);
+
+        std::array<int, maxLists> next {};
+
+        for (;;)
+        {
+            int earliest = -1;
+
+            for (int i = 0; i < numLists; ++i)
+                if (next[(size_t) i] < lists[i].size() && (earliest < 0 || lists[i][next[(size_t) i]].offset < lists[earliest][next[(size_t) earliest]].offset))
+                    earliest = i;
+
+            if (earliest < 0)
+                return;
+
+            add (lists[earliest][next[(size_t) earliest]++]);
+        }
+    }
+
+    int size() const noexcept { return numEvents; }
+    bool isEmpty() const noexcept { return numEvents == 0; }
+
+    int getCapacity() const noexcept { return static_cast<int> (events.size()); }
+
+    /** Returns how many more events can be added. */
+    int getFreeSpace() const noexcept { return getCapacity() - numEvents; }
+
+    const ArpEvent& operator[] (int index) const noexcept { return events[(size_t) index]; }
+
+    const ArpEvent* begin() const noexcept { return events.data(); }
+    const ArpEvent* end() const noexcept { return events.data() + numEvents; }
+
+private:
+    std::vector<ArpEvent> events;
+    int numEvents = 0;
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <juce_core/juce_core.h>
+#include <span>
+
+#include "HeldNotes.h"
+
+//==============================================================================
+/**
+A playback order for the arpeggiator compiled into a flat step table.
+
+compile() expands the held notes over the requested number of octaves and
+writes them out in the chosen order, so playing a step is a single table
+lookup. Steps are stored CSR-style: step i plays notes[stepStart[i]] up to
+notes[stepStart[i + 1]], which lets chord mode put every note in one step.
+
+Only call compile() when the held notes, mode or octave count change.
+*/
+class ArpPattern
+{
+public:
+    enum class Mode
+    {
+        up,
+        down,
+        upDown,
+        downUp,
+        converge,
+        diverge,
+        asPlayed,
+        chord
+    };
+
+    static constexpr int maxOctaves = 4;
+    static constexpr int maxNotes = HeldNotes::maxNotes * maxOctaves;
+    static constexpr int maxSteps = maxNotes * 2;
+
+    /** Display names of each Mode, in enum order (used for the "pattern" parameter). */
+    static juce::StringArray getModeNames()
+    {
+        return { "Up", "Down", "Up-Down", "Down-Up", "Converge", "Diverge", "As Played", "Chord" };
+    }
+
+    /** Rebuilds the step table from the held notes. */
+    void compile (const HeldNotes& heldNotes, Mode mode, int numOctaves) noexcept
+    {
+        numOctaves = juce::jlimit (1, maxOctaves, numOctaves);
+
+        // Expand held notes over octaves, either ascending or in the order they were played
+        int numExpanded = 0;
+
+        for (int octave = 0; octave < numOctaves; ++octave)
+        {
+            for (int i = 0; i < heldNotes.size(); ++i)
+            {
+                int note = (mode == Mode::asPlayed ? heldNotes.getInPlayedOrder (i) : heldNotes[i]) + 12 * octave;
+
+                if (note < HeldNotes::maxNotes)
+                    expanded[(size_t) numExpanded++] = static_cast<uint8_t> (note);
+            }
+        }
+
+        numSteps = 0;
+        numStepNotes = 0;
+
+        if (numExpanded == 0)
+            return;
+
+        auto last = numExpanded - 1;
+
+        switch (mode)
+        {
+            case Mode::up:
+            case Mode::asPlayed:
+                for (int i = 0; i <= last; ++i)
+                    addStep (i);
+                break;
+
+            case Mode::down:
+                for (int i = last; i >= 0; --i)
+                    addStep (i);
+                break;
+
+            case Mode::upDown:
+                for (int i = 0; i <= last; ++i)
+                    addStep (i);
+                for (int i = last - 1; i > 0; --i)
+                    addStep (i);
+                break;
+
+            case Mode::downUp:
+                for (int i = last; i >= 0; --i)
+                    addStep (i);
+                for (int i = 1; i < last; ++i)
+                    addStep (i);
+                break;
+
+            case Mode::converge:
+                for (int lo = 0, hi = last; lo <= hi; ++lo, --hi)
+                {
+                    addStep (lo);
+                    if (hi != lo)
+                        addStep (hi);
+                }
+                break;
+
+            case Mode::diverge:
+                for (int lo = last / 2, hi = lo + 1; lo >= 0 || hi <= last; --lo, ++hi)
+                {
+                    if (lo >= 0)
+                        addStep (lo);
+                    if (hi <= last)
+                        addStep (hi);
+                }
+                break;
+
+            case Mode::chord:
+                for (int i = 0; i <= last; ++i)
+                    notes[(size_t) numStepNotes++] = expanded[(size_t) i];
+                stepStart[(size_t) numSteps++] = 0;
+                break;
+        }
+
+        stepStart[(size_t) numSteps] = static_cast<uint16_t> (numStepNotes);
+    }
+
+    /** Returns the number of steps in one cycle of the pattern (0 if no notes are held). */
+    int getNumSteps() const noexcept { return numSteps; }
+
+    /** Returns the notes played by the given step. */
+    std::span<const uint8_t> getStep (int step) const noexcept
+    {
+        jassert (step >= 0 && step < numSteps);
+        return { notes.data() + stepStart[(size_t) step], notes.data() + stepStart[(size_t) step + 1] };
+    }
+
+private:
+    void addStep (int expandedIndex) noexcept
+    {
+        stepStart[(size_t) numSteps++] = static_cast<uint16_t> (numStepNotes);
+        notes[(size_t) numStepNotes++] = expanded[(size_t) expandedIndex];
+    }
+
+    std::array<uint8_t, maxNotes> expanded {};
+    std::array<uint8_t, maxSteps> notes {};
+    std::array<uint16_t, maxSteps + 1> stepStart {};
+
+    int numSteps = 0;
+    int numStepNotes = 0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+//==============================================================================
+/**
+A counter-based random source for the arpeggiator's decisions.
+
+Every value is a pure function of (seed, stream, counter), hashed with two
+rounds of a 32-bit integer mixer, so there is no state that carries from one
+value to the next. The same seed therefore always gives the same arp, whatever
+the block size. fill() has no loop-carried dependency, so the compiler can
+vectorise it to produce a whole block's worth of values at once.
+*/
+class ArpRandom
+{
+public:
+    /** Sets the seed all streams are derived from. */
+    void setSeed (uint32_t newSeed) noexcept { seed = newSeed; }
+
+    uint32_t getSeed() const noexcept { return seed; }
+
+    /** Returns a uniformly distributed value in [0, 1) for the given stream and counter. */
+    float getFloat (uint32_t stream, uint32_t counter) const noexcept
+    {
+        return toFloat (hash (hash (counter) ^ getStreamKey (stream)));
+    }
+
+    /** Fills dest[i] with getFloat (stream, firstCounter + i) for i in [0, num). */
+    void fill (uint32_t stream, uint32_t firstCounter, float* dest, int num) const noexcept
+    {
+        auto key = getStreamKey (stream);
+
+        for (int i = 0; i < num; ++i)
+            dest[i] = toFloat (hash (hash (firstCounter + static_cast<uint32_t> (i)) ^ key));
+    }
+
+private:
+    // Chris Wellons' "lowbias32" integer hash
+    static uint32_t hash (uint32_t x) noexcept
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Top 24 bits as a float in [0, 1)
+    static float toFloat (uint32_t x) noexcept { return static_cast<float> (x >> 8) * (1.0f / 16777216.0f); }
+
+    uint32_t getStreamKey (uint32_t stream) const noexcept { return hash (seed ^ hash (stream + 0x9e3779b9u)); }
+
+    uint32_t seed = 0;
+};
@@ -1,59 +1,105 @@
 #pragma once
 
+#include "ArpEvent.h"
+#include "ArpPattern.h"
+#include "ArpRandom.h"
+#include "HeldNotes.h"
+#include "ParameterSnapshot.h"
+#include "TransportClock.h"
+
 class Arpeggiator
 {
 public:
-    void prepareToPlay (double sampleRate,
-        std::atomic<float>* noteDurPtr,
-        std::atomic<float>* noteDurSyncPtr,
-        std::atomic<float>* randomizePtr,
-        std::atomic<float>* densityPtr,
-        std::atomic<float>* widthPtr,
-        std::atomic<float>* panPtr,
-        std::atomic<float>* ascendingPtr,
-        std::atomic<float>* syncPtr)
+    // Number of independent arp lanes running over the same held notes
+    static constexpr int maxLanes = ParameterSnapshot::numLanes;
+
+    // Shortest step a free-running lane can play, the lower end of the noteDur parameter
+    static constexpr float minNoteDuration = 0.001f;
+
+    /** Returns the events one lane has room for in a block of blockSize samples.
+
+    Free-running steps come at least every half the shortest note (at full swing).
+    A step ends the notes of the one before and starts its own, one note except
+    in chord mode, so this is a note-on and a note-off for every step plus one
+    chord of every MIDI note starting and ending. Denser chords, and synced steps
+    at extreme tempos, drop note-ons once a lane's list is full, never note-offs.
+    */
+    static int getMaxLaneEventsPerBlock (double sampleRate, int blockSize)
+    {
+        const int minStepSamples = juce::jmax (1, static_cast<int> (sampleRate * minNoteDuration * 0.5));
+        const int maxStepsPerLane = blockSize / minStepSamples + 1;
+        return 2 * (maxStepsPerLane + HeldNotes::maxNotes);
+    }
+
+    /** Returns the most events a block of blockSize samples can produce, for sizing the ArpEventList. */
+    static int getMaxEventsPerBlock (double sampleRate, int blockSize)
+    {
+        return maxLanes * getMaxLaneEventsPerBlock (sampleRate, blockSize);
+    }
+
+    /** Returns the ID of a per-lane parameter: the first lane uses paramID itself, later lanes append their number. */
+    static juce::String getLaneParamID (const juce::String& paramID, int lane)
+    {
+        return lane == 0 ? paramID : paramID + juce::String (lane + 1);
+    }
+
+    /** Sets the seed of the arp's random decisions (saved with the plugin state). Safe to call from any thread. */
+    void setSeed (uint32_t newSeed) noexcept { seed.store (newSeed); }
+
+    uint32_t getSeed() const noexcept { return seed.load(); }
+
+    void prepareToPlay (double sampleRate, int maxBlockSize)
     {
+        for (auto& lane : laneEvents)
+            lane.prepare (getMaxLaneEventsPerBlock (sampleRate, maxBlockSize));
+
         notes.clear();
+        notesChanged = true;
         sr = static_cast<float> (sampleRate);
 
-        noteDur = noteDurPtr;
-        noteDurSync = noteDurSyncPtr;
-        randomize = randomizePtr;
-        density = densityPtr;
-        width = widthPtr;
-        pan = panPtr;
-        ascending = ascendingPtr;
-        sync = syncPtr;
+        for (auto& laneSounding : sounding)
+            laneSounding.clear();
+
+        samples.fill (0);
+        stepNumber.fill (0);
+        currentStep.fill (-1);
     };
 
-    void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi, juce::Optional<juce::AudioPlayHead::PositionInfo>& infoOpt)
+    /** Reads the held notes from midi and writes the notes the arp plays in this block to events, sorted by offset. */
+    void processBlock (int bufferSamples,
+        const juce::MidiBuffer& midi,
+        juce::Optional<juce::AudioPlayHead::PositionInfo>& infoOpt,
+        const ParameterSnapshot& params,
+        ArpEventList& events)
     {
-        auto bufferSamples = buffer.getNumSamples();
-
         // Process midi
         for (const auto metadata : midi)
         {
             const auto msg = metadata.getMessage();
             if (msg.isNoteOn())
+            {
                 notes.add (msg.getNoteNumber());
+                notesChanged = true;
+            }
             else if (msg.isNoteOff())
+            {
                 notes.removeValue (msg.getNoteNumber());
+                notesChanged = true;
+            }
         }
-        midi.clear();
-
-        // Note duration in seconds
-        float noteDuration = noteDur->load();
+        for (auto& lane : laneEvents)
+            lane.clear();
 
-        // Note duration in samples
-        int noteDurSamples = static_cast<int> (noteDuration * sr);
+        // Each lane's share of the output list, so merging them never drops an event
+        laneCapacity = juce::jmin (laneEvents[0].getCapacity(), events.getCapacity() / maxLanes);
 
-        // Midi event sample offset
-        int offset = juce::jmax (0, juce::jmin ((int) (noteDurSamples - samples), bufferSamples - 1));
+        random.setSeed (seed.load());
 
-        // Condition to check when to send midi event
-        bool condition = (samples + bufferSamples) >= noteDurSamples;
+        // Host timing shared by every lane in sync mode
+        bool synced = false;
+        bool playing = false;
 
-        if (sync->load() && infoOpt.hasValue())
+        if (params.sync && infoOpt.hasValue())
         {
             juce::AudioPlayHead::PositionInfo info = *infoOpt;
             auto bpm = info.getBpm();
@@ -61,95 +107,194 @@ public:
 
             if (bpm && ppqPosition)
             {
-                int noteDurSyncIndex = static_cast<int> (noteDurSync->load());
-                int noteDenominator = std::pow (2, 7 - noteDurSyncIndex);
-                float quarterNoteSamples = 60.0f / *bpm * sr ;
-
-                if (info.getIsPlaying())
-                {
-                    float bufferPpq = bufferSamples / quarterNoteSamples;
-                    float ppqFmod = std::fmod (*ppqPosition + bufferPpq, 4.0f / noteDenominator);
-
-                    condition = ppqFmod > 0 && ppqFmod < prevPpqFmod;
-                    offset = static_cast<int> ((bufferPpq - ppqFmod) * quarterNoteSamples);
-
-                    prevPpqFmod = ppqFmod;
-                }
-                else
-                {
-                    noteDurSamples = quarterNoteSamples * 4 / noteDenominator;
-
-                    offset = juce::jmax (0, juce::jmin ((int) (noteDurSamples - samples), bufferSamples - 1));
-                    condition = (samples + bufferSamples) >= noteDurSamples;
-
-                    // Send MIDI note off event if playback stops
-                    if (condition && lastNoteValue > 0)
-                    {
-                        midi.addEvent (juce::MidiMessage::noteOff (1, lastNoteValue), 0);
-                        lastNoteValue = -1;
-                    }
-                }
+                synced = true;
+                playing = info.getIsPlaying();
+                clock.update (*ppqPosition, *bpm, sr, bufferSamples);
             }
         }
 
-        if (condition)
+        // Advance every lane over this block
+        for (int lane = 0; lane < maxLanes; ++lane)
         {
-            if (lastNoteValue > 0)
+            const auto& laneParams = params.lanes[(size_t) lane];
+            auto& output = laneEvents[(size_t) lane];
+
+            if (! laneParams.enabled)
             {
-                midi.addEvent (juce::MidiMessage::noteOff (1, lastNoteValue), offset);
-                lastNoteValue = -1;
+                releaseLane (lane, output, 0);
+                continue;
             }
 
-            if (notes.size() > 0 && random.nextFloat() < density->load())
+            updatePattern (lane, laneParams.pattern, params.numOctaves);
+
+            // Note duration in samples
+            int noteDurSamples = laneParams.noteDurSamples;
+
+            if (synced)
             {
-                // Set pan of current note, processed in PluginProcessor's processBlock()
-                float widthVal = width->load();
-                pan->store(random.nextFloat() * widthVal * 2 - widthVal);
-
-                // Select and play note from notes
-                if (ascending->load())
-                    currentNote = (currentNote + 1) % notes.size();
-                else
-                {
-                    currentNote -= 1;
-                    if (currentNote < 0)
-                        currentNote = notes.size() - 1;
-                }
+                auto stepTicks = laneParams.stepTicks;
 
-                if (random.nextFloat() < randomize->load())
+                if (playing)
                 {
-                    int randomNoteIndex = random.nextInt (notes.size());
-                    lastNoteValue = notes[randomNoteIndex];
-                }
-                else
-                {
-                    lastNoteValue = notes[currentNote];
+                    // Every step boundary on the host timeline that falls inside this block
+                    clock.forEachStep (stepTicks, params.swing, [&] (int offset, int64_t step) {
+                        queueStep (lane, params, output, offset, step);
+                        stepNumber[(size_t) lane] = step + 1;
+                    });
+
+                    flushSteps (lane, params, output);
+                    samples[(size_t) lane] = 0;
+                    continue;
                 }
 
-                midi.addEvent (juce::MidiMessage::noteOn (1, lastNoteValue, (juce::uint8) 127), offset);
+                // Not playing: free-run at the synced note length
+                noteDurSamples = juce::jmax (1, static_cast<int> (clock.getStepSamples (stepTicks)));
+            }
+
+            // Free-running: emit every step that is due in this block at its exact sample offset
+            int swingSamples = static_cast<int> (params.swing * 0.5f * noteDurSamples);
+            auto& elapsed = samples[(size_t) lane];
+            auto& nextStep = stepNumber[(size_t) lane];
+
+            // Odd steps are pushed late by swingSamples, so the gap before them grows and the gap after shrinks
+            auto stepInterval = [&] { return noteDurSamples + ((nextStep & 1) != 0 ? swingSamples : -swingSamples); };
+
+            for (int offset = juce::jmax (0, stepInterval() - elapsed); offset < bufferSamples; offset += juce::jmax (1, stepInterval()))
+            {
+                queueStep (lane, params, output, offset, nextStep);
+                elapsed = -offset;
+                ++nextStep;
             }
+
+            flushSteps (lane, params, output);
+
+            // Samples elapsed since the last step, carried over to the next block
+            elapsed += bufferSamples;
         }
 
-        samples = (samples + bufferSamples) % noteDurSamples;
+        // Each lane's events are in order already, so one merge sorts the block
+        events.merge (laneEvents.data(), maxLanes);
+
+        notesChanged = false;
     };
 
 private:
-    std::atomic<float>* noteDur;
-    std::atomic<float>* noteDurSync;
-    std::atomic<float>* randomize;
-    std::atomic<float>* density;
-    std::atomic<float>* width;
-    std::atomic<float>* pan;
-    std::atomic<float>* ascending;
-    std::atomic<float>* sync;
-
-    juce::Random random;
-
-    juce::SortedSet<int> notes;
-    int samples = 0;
-    int currentNote = 0; // index of currently playing note in notes
-    int lastNoteValue = -1; // midi value of last played note
-    float prevPpqFmod = 0.0f;
+    /** Recompiles a lane's step table if the held notes, pattern mode or octave range changed. */
+    void updatePattern (int lane, ArpPattern::Mode mode, int numOctaves)
+    {
+        if (! notesChanged && mode == compiledMode[(size_t) lane] && numOctaves == compiledOctaves[(size_t) lane])
+            return;
+
+        steps[(size_t) lane].compile (notes, mode, numOctaves);
+
+        compiledMode[(size_t) lane] = mode;
+        compiledOctaves[(size_t) lane] = numOctaves;
+    }
+
+    /** Collects a due step, its random values are generated together with the rest of the block's in flushSteps(). */
+    void queueStep (int lane, const ParameterSnapshot& params, ArpEventList& events, int offset, int64_t step)
+    {
+        if (numPending == 0)
+            pendingFirstStep = step;
+
+        pendingOffsets[(size_t) numPending++] = offset;
+
+        if (numPending == maxPendingSteps)
+            flushSteps (lane, params, events);
+    }
+
+    /** Draws the random values for all queued steps of a lane in one pass, then plays them. */
+    void flushSteps (int lane, const ParameterSnapshot& params, ArpEventList& events)
+    {
+        if (numPending == 0)
+            return;
+
+        // Queued steps are consecutive, so their counters form one contiguous range
+        random.fill (static_cast<uint32_t> (lane),
+            static_cast<uint32_t> (pendingFirstStep * randomsPerStep),
+            pendingRandoms.data(),
+            numPending * randomsPerStep);
+
+        for (int i = 0; i < numPending; ++i)
+            playStep (lane, params, events, pendingOffsets[(size_t) i], pendingRandoms.data() + i * randomsPerStep);
+
+        numPending = 0;
+    }
+
+    /** Ends the currently playing notes of a lane and (depending on density) starts its next step at offset. */
+    void playStep (int lane, const ParameterSnapshot& params, ArpEventList& events, int offset, const float* randoms)
+    {
+        const auto& laneParams = params.lanes[(size_t) lane];
+        const auto& laneSteps = steps[(size_t) lane];
+
+        releaseLane (lane, events, offset);
+
+        if (laneSteps.getNumSteps() > 0 && randoms[0] < laneParams.density)
+        {
+            // Every note of the step gets the same random pan, the voices playing them are placed there
+            float pan = randoms[1] * params.width * 2 - params.width;
+
+            const int numSteps = laneSteps.getNumSteps();
+            auto& step = currentStep[(size_t) lane];
+            step = (step + 1) % numSteps;
+
+            // A random step is drawn from the same table, so it covers the pattern's octaves too
+            int stepToPlay = step;
+
+            if (randoms[2] < laneParams.randomize)
+                stepToPlay = juce::jmin (numSteps - 1, static_cast<int> (randoms[3] * numSteps));
+
+            for (auto note : laneSteps.getStep (stepToPlay))
+                startNote (lane, events, note, offset, pan);
+        }
+    }
+
+    // Each lane plays on its own MIDI channel so lanes sharing a note don't cut each other off
+    void startNote (int lane, ArpEventList& events, int note, int offset, float pan)
+    {
+        // Keep room for the note-off of every note the lane has sounding, so a full list never leaves a note stuck
+        if (laneCapacity - events.size() < sounding[(size_t) lane].size() + 2)
+            return;
+
+        events.add ({ offset, ArpEvent::Type::noteOn, static_cast<uint8_t> (lane + 1), static_cast<uint8_t> (note), pan });
+        sounding[(size_t) lane].add (note);
+    }
+
+    void releaseLane (int lane, ArpEventList& events, int offset)
+    {
+        auto& laneSounding = sounding[(size_t) lane];
+
+        laneSounding.forEach ([&] (int note) { events.add ({ offset, ArpEvent::Type::noteOff, static_cast<uint8_t> (lane + 1), static_cast<uint8_t> (note) }); });
+        laneSounding.clear();
+    }
+
+    std::atomic<uint32_t> seed { 0 };
+    ArpRandom random;
+    TransportClock clock;
+
+    // Random values drawn per step: density, pan, randomize chance and random note
+    static constexpr int randomsPerStep = 4;
+
+    // Steps of the current lane waiting for their random values
+    static constexpr int maxPendingSteps = 64;
+    std::array<int, maxPendingSteps> pendingOffsets {};
+    std::array<float, maxPendingSteps * randomsPerStep> pendingRandoms {};
+    int64_t pendingFirstStep = 0;
+    int numPending = 0;
+
+    HeldNotes notes;
+    bool notesChanged = true;
+
+    // Per-lane state, one entry per lane so all lanes are advanced in a single loop
+    std::array<ArpPattern, maxLanes> steps;
+    std::array<ArpPattern::Mode, maxLanes> compiledMode {};
+    std::array<int, maxLanes> compiledOctaves {};
+    std::array<HeldNotes, maxLanes> sounding; // notes started by each lane's last step, released on its next one
+    std::array<int, maxLanes> samples {}; // samples elapsed since each lane's last step
+    std::array<int64_t, maxLanes> stepNumber {}; // index of each lane's next step, its parity decides swing
+    std::array<int, maxLanes> currentStep {}; // index of each lane's current step in steps
+    std::array<ArpEventList, maxLanes> laneEvents; // each lane's events in this block, merged into the output
+    int laneCapacity = 0; // events a lane may add in this block
 
     float sr { 0.0f };
-};
\ No newline at end of file
+};
@@ -1,15 +1,34 @@
 #include "ArpeggiatorComponent.h"
+#include "Arpeggiator.h"
 
 ArpeggiatorComponent::ArpeggiatorComponent (juce::AudioProcessorValueTreeState& state)
+    : valueTreeState (state)
 {
     createSliderAndAttachment (state, speedSlider, 60, speedLabel, "Note Duration", speedSliderAttachment, "noteDur");
     createSliderAndAttachment (state, speedSyncSlider, 70, speedSyncLabel, "Note Duration", speedSyncSliderAttachment, "noteDurSync");
     createSliderAndAttachment (state, randomizeSlider, 50, randomizeLabel, "Randomize", randomizeSliderAttachment, "randomize");
     createSliderAndAttachment (state, densitySlider, 50, densityLabel, "Density", densitySliderAttachment, "density");
 
-    createToggleButtonAndAttachment (state, ascendingButton, ascendingLabel, "Ascending", ascendingButtonAttachment, "ascending");
+    createComboBoxAndAttachment (state, patternSelector, patternLabel, "Pattern", patternSelectorAttachment, "pattern");
+    createComboBoxAndAttachment (state, octavesSelector, octavesLabel, "Octaves", octavesSelectorAttachment, "octaves");
     createToggleButtonAndAttachment (state, syncButton, syncLabel, "Sync to BPM", syncButtonAttachment, "sync");
-    
+    createToggleButtonAndAttachment (state, laneOnButton, laneOnLabel, "On", laneOnButtonAttachment, Arpeggiator::getLaneParamID ("laneOn", 1).toStdString());
+
+    // Lane selector, switches which lane the per-lane controls edit
+    for (int lane = 0; lane < Arpeggiator::maxLanes; ++lane)
+        laneSelector.addItem ("Lane " + juce::String (lane + 1), lane + 1);
+
+    laneSelector.onChange = [this] { showLane (laneSelector.getSelectedItemIndex()); };
+    addAndMakeVisible (laneSelector);
+
+    laneLabel.setFont (juce::Font (14.0f, juce::Font::bold));
+    laneLabel.setText ("Lane", juce::dontSendNotification);
+    laneLabel.setColour (juce::Label::textColourId, juce::Colours::white);
+    laneLabel.attachToComponent (&laneSelector, false);
+    addAndMakeVisible (laneLabel);
+
+    laneSelector.setSelectedItemIndex (0, juce::sendNotificationSync);
+
     // Add button listener
     syncButton.addListener (this);
 
@@ -35,6 +54,20 @@ ArpeggiatorComponent::ArpeggiatorComponent (juce::AudioProcessorValueTreeState&
     addAndMakeVisible (widthLabel);
 
     widthSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (state, "width", widthSlider);
+
+    // Swing slider
+    swingSlider.setSliderStyle (juce::Slider::LinearBar);
+    swingSlider.setTextBoxStyle (juce::Slider::TextBoxRight, true, 60, 20);
+    swingSlider.setTextBoxIsEditable (true);
+    addAndMakeVisible (swingSlider);
+
+    swingLabel.setFont (juce::Font (14.0f, juce::Font::bold));
+    swingLabel.setText ("Swing", juce::dontSendNotification);
+    swingLabel.setColour (juce::Label::textColourId, juce::Colours::white);
+    swingLabel.attachToComponent (&swingSlider, false);
+    addAndMakeVisible (swingLabel);
+
+    swingSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (state, "swing", swingSlider);
 }
 
 //==============================================================================
@@ -46,7 +79,7 @@ void ArpeggiatorComponent::paint (juce::Graphics& g)
 void ArpeggiatorComponent::resized()
 {
     const int sliderYOffset = 20;
-    const int sliderSize = 130;
+    const int sliderSize = 110;
 
     speedSlider.setBounds (10, sliderYOffset, sliderSize, sliderSize);
     speedLabel.setBounds (speedSlider.getX(), speedSlider.getY() - 15, sliderSize, sliderSize);
@@ -60,11 +93,16 @@ void ArpeggiatorComponent::resized()
     densitySlider.setBounds (randomizeSlider.getX() + sliderSize + 10, sliderYOffset, sliderSize, sliderSize);
     densityLabel.setBounds (densitySlider.getX(), densitySlider.getY() - 15, sliderSize, sliderSize);
 
-    ascendingButton.setBounds (45, speedSlider.getY() + sliderSize + 40, 100, 40);
-    syncButton.setBounds (ascendingButton.getX() + 100, ascendingButton.getY(), 100, 40);
+    laneSelector.setBounds (densitySlider.getRight() + 10, sliderYOffset + 10, 60, 20);
+    laneOnButton.setBounds (laneSelector.getX(), laneSelector.getBottom() + 25, 60, 40);
+    swingSlider.setBounds (laneSelector.getX(), laneOnButton.getBottom() + 25, 60, 20);
+
+    patternSelector.setBounds (10, speedSlider.getY() + sliderSize + 50, 100, 20);
+    octavesSelector.setBounds (patternSelector.getRight() + 10, patternSelector.getY(), 70, 20);
+    syncButton.setBounds (octavesSelector.getRight() + 10, patternSelector.getY() - 10, 90, 40);
 
-    const int widthSliderSize = 150;
-    widthSlider.setBounds (getWidth() - widthSliderSize - 20, ascendingButton.getY(), widthSliderSize, 40);
+    const int widthSliderSize = 130;
+    widthSlider.setBounds (getWidth() - widthSliderSize - 20, syncButton.getY(), widthSliderSize, 40);
 }
 
 void ArpeggiatorComponent::buttonClicked (juce::Button* button)
@@ -84,6 +122,36 @@ void ArpeggiatorComponent::buttonClicked (juce::Button* button)
     }
 }
 
+void ArpeggiatorComponent::showLane (int lane)
+{
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
+
+    auto laneParamID = [lane] (const juce::String& paramID) { return Arpeggiator::getLaneParamID (paramID, lane); };
+
+    // Old attachments must be destroyed before the controls are attached to new params
+    speedSliderAttachment.reset();
+    speedSyncSliderAttachment.reset();
+    randomizeSliderAttachment.reset();
+    densitySliderAttachment.reset();
+    patternSelectorAttachment.reset();
+    laneOnButtonAttachment.reset();
+
+    speedSliderAttachment = std::make_unique<SliderAttachment> (valueTreeState, laneParamID ("noteDur"), speedSlider);
+    speedSyncSliderAttachment = std::make_unique<SliderAttachment> (valueTreeState, laneParamID ("noteDurSync"), speedSyncSlider);
+    randomizeSliderAttachment = std::make_unique<SliderAttachment> (valueTreeState, laneParamID ("randomize"), randomizeSlider);
+    densitySliderAttachment = std::make_unique<SliderAttachment> (valueTreeState, laneParamID ("density"), densitySlider);
+    patternSelectorAttachment = std::make_unique<ComboBoxAttachment> (valueTreeState, laneParamID ("pattern"), patternSelector);
+
+    // The first lane is always on
+    laneOnButton.setVisible (lane > 0);
+    laneOnLabel.setVisible (lane > 0);
+
+    if (lane > 0)
+        laneOnButtonAttachment = std::make_unique<ButtonAttachment> (valueTreeState, laneParamID ("laneOn"), laneOnButton);
+}
+
 void ArpeggiatorComponent::createSliderAndAttachment (
     juce::AudioProcessorValueTreeState& state,
     juce::Slider& slider,
@@ -109,6 +177,26 @@ void ArpeggiatorComponent::createSliderAndAttachment (
     attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (state, paramID, slider);
 }
 
+void ArpeggiatorComponent::createComboBoxAndAttachment (
+    juce::AudioProcessorValueTreeState& state,
+    juce::ComboBox& comboBox,
+    juce::Label& label,
+    std::string labelText,
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>& attachment,
+    std::string paramID)
+{
+    comboBox.addItemList (state.getParameter (paramID)->getAllValueStrings(), 1);
+    addAndMakeVisible (comboBox);
+
+    label.setFont (juce::Font (14.0f, juce::Font::bold));
+    label.setText (labelText, juce::dontSendNotification);
+    label.setColour (juce::Label::textColourId, juce::Colours::white);
+    label.attachToComponent (&comboBox, false);
+    addAndMakeVisible (label);
+
+    attachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (state, paramID, comboBox);
+}
+
 void ArpeggiatorComponent::createToggleButtonAndAttachment(
     juce::AudioProcessorValueTreeState& state,
     juce::ToggleButton& button,
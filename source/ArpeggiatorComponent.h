@@ -15,6 +15,9 @@ public:
     void buttonClicked (juce::Button* button) override;
 
 private:
+    /** Re-attaches the per-lane controls to the given lane's parameters. */
+    void showLane (int lane);
+
     void createSliderAndAttachment (
         juce::AudioProcessorValueTreeState& state,
         juce::Slider& slider,
@@ -24,6 +27,14 @@ private:
         std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>& attachment,
         std::string paramID);
 
+    void createComboBoxAndAttachment (
+        juce::AudioProcessorValueTreeState& state,
+        juce::ComboBox& comboBox,
+        juce::Label& label,
+        std::string labelText,
+        std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>& attachment,
+        std::string paramID);
+
     void createToggleButtonAndAttachment (
         juce::AudioProcessorValueTreeState& state,
         juce::ToggleButton& button,
@@ -32,28 +43,42 @@ private:
         std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>& attachment,
         std::string paramID);
 
+    juce::AudioProcessorValueTreeState& valueTreeState;
+
+    juce::ComboBox laneSelector;
+    juce::ToggleButton laneOnButton;
+
     juce::Slider speedSlider;
     juce::Slider speedSyncSlider;
     juce::Slider randomizeSlider;
     juce::Slider densitySlider;
     juce::Slider widthSlider;
+    juce::Slider swingSlider;
 
-    juce::ToggleButton ascendingButton;
+    juce::ComboBox patternSelector;
+    juce::ComboBox octavesSelector;
     juce::ToggleButton syncButton;
 
+    juce::Label laneLabel;
+    juce::Label laneOnLabel;
     juce::Label speedLabel;
     juce::Label speedSyncLabel;
     juce::Label randomizeLabel;
     juce::Label densityLabel;
     juce::Label widthLabel;
-    juce::Label ascendingLabel;
+    juce::Label swingLabel;
+    juce::Label patternLabel;
+    juce::Label octavesLabel;
     juce::Label syncLabel;
 
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> laneOnButtonAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> speedSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> speedSyncSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> randomizeSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> densitySliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> widthSliderAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> ascendingButtonAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> swingSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> patternSelectorAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> octavesSelectorAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> syncButtonAttachment;
 };
\ No newline at end of file
@@ -0,0 +1,394 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+A multi-stage envelope built from a list of segments.
+
+Each segment moves from the level the previous one ended on to its own level
+over a given time, along the exponential curve(). When a note starts the
+segments before the sustain point run in order, then the envelope holds the
+level the last of them reached until noteOff(), which moves on to the
+release segments from wherever the envelope is. A loop range among the
+segments before the sustain point repeats while the note is held, so the
+envelope can pulse in time under the arp. Segments of length 0 are skipped,
+but their level still carries to the next one.
+
+setSegments() compiles the list into a table of stage lengths and levels.
+Each stage is generated with a recursive exponential, y[n + 1] = y[n] * r + c,
+so per sample the envelope only multiplies and adds, and the table is only
+looked at again where one stage hands over to the next.
+*/
+class Envelope
+{
+public:
+    static constexpr int maxSegments = 16;
+
+    /** One stage of the envelope. */
+    struct Segment
+    {
+        float seconds = 0.0f; // length of the segment, 0 skips it
+        float level = 0.0f; // level reached at the end of the segment
+        float expo = 0.1f; // curvature, see curve()
+    };
+
+    //==============================================================================
+    /**
+    Static function that maps domain [0, 1] -> range [0, 1] using an exponential curve
+
+    This is the shape of a rising (ascending) or falling segment. getNextSample()
+    doesn't call it per sample: each segment is generated with a recursive
+    exponential set up from this curve once when the segment starts. The
+    recursion runs in double precision and stays within 1e-5 of curve() over
+    any segment length the parameters allow.
+    */
+    static float curve (float x, float expo, bool ascending)
+    {
+        if (ascending == true)
+            return (std::exp (expo * x) - 1) / (std::exp (expo) - 1);
+        else
+            return (std::exp (-1 * expo * (x - 1)) - 1) / (std::exp (expo) - 1);
+    }
+
+    //==============================================================================
+    /** Sets the sample rate that will be used for the envelope.
+
+    This must be called before the getNextSample() or setSegments() methods.
+    */
+    void setSampleRate (double newSampleRate) noexcept
+    {
+        jassert (newSampleRate > 0.0);
+        sampleRate = newSampleRate;
+    }
+
+    /** Compiles the segment list the envelope runs through.
+
+    Segments [0, sustainPoint) run after noteOn(), segments [sustainPoint, numSegments)
+    after noteOff(). If loopStart and loopEnd are set, segments [loopStart, loopEnd]
+    repeat while the note is held instead of going on to the sustain; they must come
+    before the sustain point.
+
+    A segment that is playing keeps its length. If its level or curvature changed it
+    continues from the same position with the new shape.
+    */
+    void setSegments (const Segment* segments, int numSegments, int newSustainPoint, int newLoopStart = -1, int newLoopEnd = -1) noexcept
+    {
+        // need to call setSampleRate() first!
+        jassert (sampleRate > 0.0);
+        jassert (numSegments <= maxSegments && newSustainPoint >= 0 && newSustainPoint <= numSegments);
+
+        numStages = juce::jmin (numSegments, maxSegments);
+        sustainPoint = juce::jlimit (0, numStages, newSustainPoint);
+
+        bool shapeChanged = false;
+        double loopLength = 0.0;
+
+        for (int i = 0; i < numStages; ++i)
+        {
+            auto& stage = stages[(size_t) i];
+            const auto& newSegment = segments[i];
+            auto expo = static_cast<double> (newSegment.expo);
+
+            if (i == segment && (expo != stage.expo || newSegment.level != stage.endLevel))
+                shapeChanged = true;
+
+            stage.numSamples = newSegment.seconds * sampleRate;
+            stage.endLevel = newSegment.level;
+            stage.expo = expo;
+            stage.range = std::exp (expo) - 1.0;
+
+            if (i >= newLoopStart && i <= newLoopEnd)
+                loopLength += stage.numSamples;
+        }
+
+        // Sustain at the level the last segment before the sustain point reaches
+        sustainLevel = static_cast<float> (sustainPoint > 0 ? stages[(size_t) sustainPoint - 1].endLevel : 0.0);
+
+        // A loop needs at least one sample, or it would never leave the stage it jumps to
+        bool loopValid = newLoopStart >= 0 && newLoopStart <= newLoopEnd && newLoopEnd < sustainPoint && loopLength > 0.0;
+        loopStart = loopValid ? newLoopStart : -1;
+        loopEnd = loopValid ? newLoopEnd : -1;
+
+        if (state == State::running)
+        {
+            if (segment >= numStages)
+                reset();
+            else if (shapeChanged)
+                startSegment (sampleDelta, segmentStartLevel);
+        }
+    }
+
+    /** Returns true if the envelope is running a segment or sustaining. */
+    bool isActive() const noexcept { return state != State::idle; }
+
+    /** Returns true if the envelope is in one of its release segments. */
+    bool isReleasing() const noexcept { return state == State::running && segment >= sustainPoint; }
+
+    /** Returns the last envelope value that was generated. */
+    float getCurrentValue() const noexcept { return state == State::idle ? 0.0f : envelopeVal; }
+
+    //==============================================================================
+    /** Resets the envelope to an idle state. */
+    void reset() noexcept
+    {
+        envelopeVal = 0.0f;
+        numSamples = 0;
+        segment = -1;
+        state = State::idle;
+    }
+
+    /** Starts the first segment of the envelope. */
+    void noteOn() noexcept
+    {
+        sampleDelta = 0;
+        enterSegment (0, 0, 0.0);
+    }
+
+    /** Starts the release segments from the current level. */
+    void noteOff() noexcept
+    {
+        if (state != State::idle)
+        {
+            sampleDelta = 0;
+            enterSegment (sustainPoint, 0, envelopeVal);
+        }
+    }
+
+    //==============================================================================
+    /** Returns the next sample value of the envelope.
+
+    @see applyEnvelopeToBuffer
+    */
+    float getNextSample() noexcept
+    {
+        switch (state)
+        {
+            case State::idle:
+            {
+                return 0.0f;
+            }
+
+            case State::running:
+            {
+                envelopeVal = static_cast<float> (segmentValue);
+
+                if (sampleDelta > numSamples)
+                    goToNextSegment();
+                else
+                    segmentValue = segmentValue * segmentMultiplier + segmentIncrement;
+
+                break;
+            }
+
+            case State::sustain:
+            {
+                envelopeVal = sustainLevel;
+                break;
+            }
+        }
+
+        ++sampleDelta;
+
+        return envelopeVal;
+    }
+
+    /** This method will conveniently apply the next numSamples number of envelope values
+    to an AudioBuffer.
+
+    @see getNextSample
+    */
+    void applyEnvelopeToBuffer (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        jassert (startSample + numSamples <= buffer.getNumSamples());
+
+        if (state == State::idle)
+        {
+            buffer.clear (startSample, numSamples);
+            return;
+        }
+
+        if (state == State::sustain)
+        {
+            buffer.applyGain (startSample, numSamples, sustainLevel);
+            return;
+        }
+
+        // Generate the envelope into a gain array one chunk at a time, then multiply each channel by it
+        constexpr int chunkSize = 256;
+        float gains[chunkSize];
+
+        while (numSamples > 0)
+        {
+            auto num = juce::jmin (numSamples, chunkSize);
+            renderEnvelope (gains, num, 1);
+
+            for (int i = 0; i < buffer.getNumChannels(); ++i)
+                juce::FloatVectorOperations::multiply (buffer.getWritePointer (i, startSample), gains, num);
+
+            startSample += num;
+            numSamples -= num;
+        }
+    }
+
+    /** Writes the next numValues envelope values to dest, stride floats apart.
+
+    The envelope is generated a segment at a time: the samples of a segment up to
+    its end are written by a tight loop and only the sample where one segment
+    hands over to the next goes through getNextSample(). The voice bank uses
+    a stride to interleave the envelopes of a group of voices.
+
+    @see getNextSample
+    */
+    void renderEnvelope (float* dest, int numValues, int stride) noexcept
+    {
+        int i = 0;
+
+        while (i < numValues)
+        {
+            if (state != State::running)
+            {
+                auto value = state == State::idle ? 0.0f : sustainLevel;
+                envelopeVal = value;
+
+                for (; i < numValues; ++i)
+                    dest[i * stride] = value;
+
+                return;
+            }
+
+            // Samples left before the one where sampleDelta passes numSamples and the segment ends
+            auto numInStage = juce::jmin (numValues - i, static_cast<int> (numSamples) + 1 - sampleDelta);
+
+            if (numInStage > 0)
+            {
+                auto value = segmentValue;
+
+                for (int end = i + numInStage; i < end; ++i)
+                {
+                    dest[i * stride] = static_cast<float> (value);
+                    value = value * segmentMultiplier + segmentIncrement;
+                }
+
+                envelopeVal = dest[(i - 1) * stride];
+                segmentValue = value;
+                sampleDelta += numInStage;
+            }
+
+            if (i < numValues)
+                dest[i++ * stride] = getNextSample();
+        }
+    }
+
+private:
+    //==============================================================================
+    /** Starts the first segment from index on that has a length, coming from startLevel.
+
+    Running out of segments before the sustain point holds the sustain, running out
+    of release segments ends the note.
+    */
+    void enterSegment (int index, int firstSample, double startLevel) noexcept
+    {
+        const bool beforeSustain = index < sustainPoint;
+        const int end = beforeSustain ? sustainPoint : numStages;
+
+        for (; index < end && stages[(size_t) index].numSamples <= 0.0; ++index)
+            startLevel = stages[(size_t) index].endLevel;
+
+        if (index == end)
+        {
+            if (beforeSustain)
+                startSustain();
+            else
+                reset();
+
+            return;
+        }
+
+        segment = index;
+        numSamples = stages[(size_t) index].numSamples;
+        state = State::running;
+        startSegment (firstSample, startLevel);
+    }
+
+    /** Sets up the recursion that generates the current segment's curve, starting at sample firstSample.
+
+    The value at sample n is scale * curve (n / numSamples) + offset, so with r = exp (+-expo / numSamples)
+    each sample is the previous one times r plus a constant.
+    */
+    void startSegment (int firstSample, double startLevel) noexcept
+    {
+        const auto& stage = stages[(size_t) segment];
+        const double expo = stage.expo;
+        const double range = stage.range;
+        const bool ascending = stage.endLevel > startLevel;
+
+        // Rising segments follow the curve up from the start, falling ones follow it down to the end
+        double scale = ascending ? stage.endLevel - startLevel : startLevel - stage.endLevel;
+        double offset = ascending ? startLevel : stage.endLevel;
+
+        auto x = firstSample / numSamples;
+        auto start = ascending ? std::exp (expo * x) - 1.0 : std::exp (expo * (1.0 - x)) - 1.0;
+
+        segmentStartLevel = startLevel;
+        segmentMultiplier = std::exp ((ascending ? expo : -expo) / numSamples);
+        segmentValue = scale * start / range + offset;
+        segmentIncrement = scale * (segmentMultiplier - 1.0) / range + offset * (1.0 - segmentMultiplier);
+    }
+
+    void goToNextSegment() noexcept
+    {
+        sampleDelta = 0;
+
+        // getNextSample() counts this call's sample as the next segment's first, so its curve starts one step in
+        auto next = segment == loopEnd ? loopStart : segment + 1;
+
+        if (next == sustainPoint)
+            startSustain();
+        else
+            enterSegment (next, 1, stages[(size_t) segment].endLevel);
+    }
+
+    void startSustain() noexcept
+    {
+        numSamples = 0;
+        segment = -1;
+        state = State::sustain;
+    }
+
+    //==============================================================================
+    // A compiled segment
+    struct Stage
+    {
+        double numSamples = 0.0;
+        double endLevel = 0.0;
+        double expo = 0.0;
+        double range = 0.0; // exp (expo) - 1, the curve's normalisation
+    };
+
+    enum class State { idle,
+        running,
+        sustain };
+
+    std::array<Stage, maxSegments> stages;
+    int numStages = 0;
+    int sustainPoint = 0;
+    int loopStart = -1, loopEnd = -1;
+    float sustainLevel = 0.0f;
+
+    State state = State::idle;
+    int segment = -1;
+
+    double sampleRate = 44100.0;
+    float envelopeVal = 0.0f;
+
+    // Variables to keep track of which sample we are at in a segment
+    int sampleDelta = 0;
+    double numSamples = 0;
+
+    // Recursive exponential generating the current segment
+    double segmentValue = 0.0;
+    double segmentMultiplier = 1.0;
+    double segmentIncrement = 0.0;
+    double segmentStartLevel = 0.0;
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+//==============================================================================
+/**
+A fixed-size set of held MIDI note numbers (0-127) stored as a 128-bit mask.
+
+Adding and removing a note are single bit operations and never touch the heap,
+so the set can be updated freely on the audio thread. Like juce::SortedSet,
+notes are indexed in ascending order: operator[] returns the nth held note by
+selecting the nth set bit (popcount per word, then per byte, then per bit).
+
+The order in which notes were added is also kept in a fixed array for the
+"as played" arp pattern; removing a note shifts that array (at most 127 bytes).
+*/
+class HeldNotes
+{
+public:
+    static constexpr int maxNotes = 128;
+
+    /** Adds a note to the set (does nothing if it is already held). */
+    void add (int note) noexcept
+    {
+        if (! isValid (note) || contains (note))
+            return;
+
+        words[wordIndex (note)] |= bitMask (note);
+        playedOrder[(size_t) numPlayed++] = static_cast<uint8_t> (note);
+    }
+
+    /** Removes a note from the set (does nothing if it is not held). */
+    void removeValue (int note) noexcept
+    {
+        if (! contains (note))
+            return;
+
+        words[wordIndex (note)] &= ~bitMask (note);
+
+        auto end = playedOrder.begin() + numPlayed;
+        auto position = std::find (playedOrder.begin(), end, static_cast<uint8_t> (note));
+        std::copy (position + 1, end, position);
+        --numPlayed;
+    }
+
+    /** Returns true if the given note is held. */
+    bool contains (int note) const noexcept
+    {
+        return isValid (note) && (words[wordIndex (note)] & bitMask (note)) != 0;
+    }
+
+    /** Removes all notes. */
+    void clear() noexcept
+    {
+        words = {};
+        numPlayed = 0;
+    }
+
+    /** Returns the number of held notes. */
+    int size() const noexcept { return std::popcount (words[0]) + std::popcount (words[1]); }
+
+    /** Returns true if no notes are held. */
+    bool isEmpty() const noexcept { return (words[0] | words[1]) == 0; }
+
+    /** Returns the held note at the given ascending index, or -1 if the index is out of range. */
+    int operator[] (int index) const noexcept
+    {
+        if (index < 0)
+            return -1;
+
+        for (int w = 0; w < numWords; ++w)
+        {
+            int count = std::popcount (words[w]);
+
+            if (index < count)
+                return w * 64 + selectInWord (words[w], index);
+
+            index -= count;
+        }
+
+        return -1;
+    }
+
+    /** Returns the held note at the given index in the order the notes were added. */
+    int getInPlayedOrder (int index) const noexcept
+    {
+        return index >= 0 && index < numPlayed ? playedOrder[(size_t) index] : -1;
+    }
+
+    /** Calls fn (note) for every held note in ascending order. */
+    template <typename Fn>
+    void forEach (Fn&& fn) const
+    {
+        for (int w = 0; w < numWords; ++w)
+            for (auto word = words[w]; word != 0; word &= word - 1)
+                fn (w * 64 + std::countr_zero (word));
+    }
+
+    /** Returns the lowest held note, or -1 if the set is empty. */
+    int getFirst() const noexcept
+    {
+        if (words[0] != 0)
+            return std::countr_zero (words[0]);
+
+        if (words[1] != 0)
+            return 64 + std::countr_zero (words[1]);
+
+        return -1;
+    }
+
+private:
+    static constexpr int numWords = maxNotes / 64;
+
+    static bool isValid (int note) noexcept { return note >= 0 && note < maxNotes; }
+    static int wordIndex (int note) noexcept { return note >> 6; }
+    static uint64_t bitMask (int note) noexcept { return uint64_t { 1 } << (note & 63); }
+
+    // Position of the nth (0-based) set bit in word, which must have more than n bits set
+    static int selectInWord (uint64_t word, int n) noexcept
+    {
+        int bitOffset = 0;
+
+        // Skip whole bytes first so the bit-by-bit search below is at most 8 iterations
+        for (;; bitOffset += 8)
+        {
+            int count = std::popcount (static_cast<uint8_t> (word >> bitOffset));
+
+            if (n < count)
+                break;
+
+            n -= count;
+        }
+
+        auto byte = static_cast<uint8_t> (word >> bitOffset);
+
+        for (; n > 0; --n)
+            byte &= static_cast<uint8_t> (byte - 1);
+
+        return bitOffset + std::countr_zero (byte);
+    }
+
+    std::array<uint64_t, numWords> words {};
+
+    std::array<uint8_t, maxNotes> playedOrder {};
+    int numPlayed = 0;
+};
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <bitset>
+
+//==============================================================================
+/**
+Passes notes between the on-screen keyboard and the audio thread without locks.
+
+juce::MidiKeyboardState::processNextMidiBuffer() takes the keyboard state's
+lock on the audio thread, so it can wait on the GUI. Instead the bridge
+listens to the keyboard state on the message thread and queues the notes
+played on it in a single-producer single-consumer FIFO, which the audio
+thread merges into its MIDI. In the other direction the host's notes are
+queued in a second FIFO and shown on the keyboard by updateDisplay().
+
+That second FIFO is only fed while the editor has switched it on with
+setDisplayActive(). Both FIFOs drop notes when they are full rather than wait.
+
+The notes from the keyboard are merged with the host's into a MidiBuffer the
+bridge allocates up front, so the host's buffer is never grown on the audio
+thread.
+*/
+class KeyboardBridge : private juce::MidiKeyboardState::Listener
+{
+public:
+    static constexpr int capacity = 256;
+
+    // Host events the merged buffer has room for next to the keyboard's
+    static constexpr int maxHostEvents = 4096;
+
+    // Bytes a short MIDI message takes in a juce::MidiBuffer: sample position, size and data
+    static constexpr int midiBufferBytesPerEvent = (int) (sizeof (juce::int32) + sizeof (juce::uint16)) + 3;
+
+    explicit KeyboardBridge (juce::MidiKeyboardState& stateToUse)
+        : keyboardState (stateToUse)
+    {
+        keyboardState.addListener (this);
+        merged.ensureSize ((size_t) ((maxHostEvents + capacity) * midiBufferBytesPerEvent));
+    }
+
+    ~KeyboardBridge() override
+    {
+        keyboardState.removeListener (this);
+    }
+
+    //==============================================================================
+    /** Queues the host's notes in midi for the display and returns the block's input with the keyboard's notes added.
+
+    That is midi itself unless notes were played on the keyboard, which are then
+    merged with a copy of midi and placed at the start of the block. The returned
+    buffer is valid until the next call. Call on the audio thread only.
+    */
+    const juce::MidiBuffer& processNextMidiBuffer (const juce::MidiBuffer& midi) noexcept
+    {
+        if (displayActive.load (std::memory_order_relaxed))
+        {
+            for (const auto metadata : midi)
+            {
+                const auto msg = metadata.getMessage();
+
+                if (msg.isNoteOnOrOff())
+                    toDisplay.push ({ msg.getChannel(), msg.getNoteNumber(), msg.getFloatVelocity(), msg.isNoteOn() });
+            }
+        }
+
+        if (! toAudio.hasNotes())
+            return midi;
+
+        merged.clear();
+        merged.addEvents (midi, 0, -1, 0);
+
+        toAudio.pop ([&] (const Note& note) { merged.addEvent (note.toMidiMessage(), 0); });
+        return merged;
+    }
+
+    //==============================================================================
+    /** Turns the display feed on or off. Called by the editor on the message thread as it opens and closes.
+
+    Host notes that ended while the feed was off would stay lit, so either way the
+    keys lit for the host are released and anything still queued is dropped.
+    */
+    void setDisplayActive (bool shouldBeActive)
+    {
+        displayActive.store (false, std::memory_order_relaxed);
+
+        const juce::ScopedValueSetter<bool> showing (showingHostNotes, true);
+
+        toDisplay.pop ([] (const Note&) {});
+
+        for (int channel = 1; channel <= 16; ++channel)
+            for (int noteNumber = 0; noteNumber < 128; ++noteNumber)
+                if (hostNotes[(size_t) channel - 1][(size_t) noteNumber])
+                    keyboardState.noteOff (channel, noteNumber, 0.0f);
+
+        hostNotes = {};
+
+        displayActive.store (shouldBeActive, std::memory_order_relaxed);
+    }
+
+    /** Shows the host's notes queued since the last call on the keyboard. Call on the message thread only. */
+    void updateDisplay()
+    {
+        // The keyboard state calls back into the listener, which must not send these notes to the audio thread
+        const juce::ScopedValueSetter<bool> showing (showingHostNotes, true);
+
+        toDisplay.pop ([&] (const Note& note) {
+            hostNotes[(size_t) note.channel - 1][(size_t) note.noteNumber] = note.isOn;
+
+            if (note.isOn)
+                keyboardState.noteOn (note.channel, note.noteNumber, note.velocity);
+            else
+                keyboardState.noteOff (note.channel, note.noteNumber, note.velocity);
+        });
+    }
+
+private:
+    struct Note
+    {
+        int channel = 1;
+        int noteNumber = 0;
+        float velocity = 0.0f;
+        bool isOn = false;
+
+        juce::MidiMessage toMidiMessage() const noexcept
+        {
+            return isOn ? juce::MidiMessage::noteOn (channel, noteNumber, velocity)
+                        : juce::MidiMessage::noteOff (channel, noteNumber, velocity);
+        }
+    };
+
+    // Wait-free single-producer single-consumer queue of notes
+    class NoteFifo
+    {
+    public:
+        void push (const Note& note) noexcept
+        {
+            const auto scope = fifo.write (1);
+
+            if (scope.blockSize1 > 0)
+                notes[(size_t) scope.startIndex1] = note;
+        }
+
+        bool hasNotes() const noexcept { return fifo.getNumReady() > 0; }
+
+        template <typename Callback>
+        void pop (Callback&& callback)
+        {
+            const auto scope = fifo.read (fifo.getNumReady());
+            scope.forEach ([&] (int index) { callback (notes[(size_t) index]); });
+        }
+
+    private:
+        juce::AbstractFifo fifo { capacity };
+        std::array<Note, capacity> notes {};
+    };
+
+    void handleNoteOn (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override
+    {
+        if (! showingHostNotes)
+            toAudio.push ({ midiChannel, midiNoteNumber, velocity, true });
+    }
+
+    void handleNoteOff (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override
+    {
+        if (! showingHostNotes)
+            toAudio.push ({ midiChannel, midiNoteNumber, velocity, false });
+    }
+
+    juce::MidiKeyboardState& keyboardState;
+
+    NoteFifo toAudio; // keyboard -> audio thread
+    juce::MidiBuffer merged; // audio thread only, the host's notes and the keyboard's
+    NoteFifo toDisplay; // audio thread -> keyboard
+    std::atomic<bool> displayActive { false };
+
+    // Message thread only
+    bool showingHostNotes = false;
+    std::array<std::bitset<128>, 16> hostNotes {}; // keys lit for the host, per MIDI channel
+
+    JUCE_DECLARE_NON_COPYABLE (KeyboardBridge)
+};
@@ -0,0 +1,106 @@
+#include "ParameterPublisher.h"
+#include "Arpeggiator.h"
+
+ParameterPublisher::ParameterPublisher (juce::AudioProcessorValueTreeState& state)
+    : processor (state.processor),
+      width (state.getRawParameterValue ("width")),
+      octaves (state.getRawParameterValue ("octaves")),
+      sync (state.getRawParameterValue ("sync")),
+      swing (state.getRawParameterValue ("swing")),
+      gain (state.getRawParameterValue ("gain")),
+      osc (state.getRawParameterValue ("osc")),
+      adsr ({ state.getRawParameterValue ("attack"),
+          state.getRawParameterValue ("decay"),
+          state.getRawParameterValue ("sustain"),
+          state.getRawParameterValue ("release"),
+          state.getRawParameterValue ("expo") }),
+      delay (state.getRawParameterValue ("delay")),
+      hold (state.getRawParameterValue ("hold")),
+      envLoop (state.getRawParameterValue ("envLoop")),
+      polyphony (state.getRawParameterValue ("polyphony")),
+      midiOnly (state.getRawParameterValue ("midiOnly"))
+{
+    for (int lane = 0; lane < ParameterSnapshot::numLanes; ++lane)
+    {
+        auto laneParam = [&] (const juce::String& paramID) { return state.getRawParameterValue (Arpeggiator::getLaneParamID (paramID, lane)); };
+
+        laneParams[(size_t) lane] = {
+            lane == 0 ? nullptr : laneParam ("laneOn"),
+            laneParam ("noteDur"),
+            laneParam ("noteDurSync"),
+            laneParam ("randomize"),
+            laneParam ("density"),
+            laneParam ("pattern")
+        };
+    }
+
+    for (auto* param : processor.getParameters())
+        param->addListener (this);
+}
+
+ParameterPublisher::~ParameterPublisher()
+{
+    for (auto* param : processor.getParameters())
+        param->removeListener (this);
+}
+
+void ParameterPublisher::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    rebuild();
+}
+
+const ParameterSnapshot& ParameterPublisher::update()
+{
+    // A change that lands while rebuilding bumps the count again, so it's picked up next block
+    auto count = changeCount.load();
+
+    if (count != builtChangeCount)
+    {
+        builtChangeCount = count;
+        rebuild();
+    }
+
+    return snapshot;
+}
+
+void ParameterPublisher::parameterValueChanged (int, float)
+{
+    changeCount.fetch_add (1);
+}
+
+void ParameterPublisher::parameterGestureChanged (int, bool)
+{
+}
+
+void ParameterPublisher::rebuild()
+{
+    for (int lane = 0; lane < ParameterSnapshot::numLanes; ++lane)
+    {
+        const auto& params = laneParams[(size_t) lane];
+        auto& snapshotLane = snapshot.lanes[(size_t) lane];
+
+        snapshotLane.enabled = params.enabled == nullptr || params.enabled->load() >= 0.5f;
+        snapshotLane.noteDurSamples = juce::jmax (1, static_cast<int> (params.noteDur->load() * sampleRate));
+        snapshotLane.stepTicks = TransportClock::getStepTicks (static_cast<int> (params.noteDurSync->load()));
+        snapshotLane.randomize = params.randomize->load();
+        snapshotLane.density = params.density->load();
+        snapshotLane.pattern = static_cast<ArpPattern::Mode> (static_cast<int> (params.pattern->load()));
+    }
+
+    snapshot.width = width->load();
+    snapshot.numOctaves = static_cast<int> (octaves->load()) + 1;
+    snapshot.sync = sync->load() >= 0.5f;
+    snapshot.swing = swing->load();
+
+    snapshot.gain = gain->load();
+    snapshot.waveform = static_cast<int> (osc->load());
+    snapshot.envelope = { adsr[0]->load(), adsr[1]->load(), adsr[2]->load(), adsr[3]->load(), adsr[4]->load() };
+    snapshot.envelope.delay = delay->load();
+    snapshot.envelope.hold = hold->load();
+    snapshot.envelope.loop = envLoop->load() >= 0.5f;
+    snapshot.polyphony = static_cast<int> (polyphony->load());
+    snapshot.midiOnly = midiOnly->load() >= 0.5f;
+
+    ++snapshot.version;
+}
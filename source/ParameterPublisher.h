@@ -0,0 +1,70 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "ParameterSnapshot.h"
+
+//==============================================================================
+/**
+Builds the ParameterSnapshot the audio thread works from.
+
+Every parameter of the processor reports its changes here, which only bumps
+a counter. update() is called once at the start of each block and rebuilds
+the snapshot from the APVTS atomics if the counter moved since the last
+build, so a block without parameter changes costs a single atomic load.
+*/
+class ParameterPublisher : private juce::AudioProcessorParameter::Listener
+{
+public:
+    explicit ParameterPublisher (juce::AudioProcessorValueTreeState& state);
+    ~ParameterPublisher() override;
+
+    /** Sets the sample rate the derived values are computed for and rebuilds the snapshot. */
+    void prepare (double sampleRate);
+
+    /** Returns the snapshot for this block, rebuilding it first if any parameter changed. Call on the audio thread only. */
+    const ParameterSnapshot& update();
+
+    const ParameterSnapshot& getSnapshot() const noexcept { return snapshot; }
+
+private:
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override;
+
+    void rebuild();
+
+    struct LaneParameters
+    {
+        std::atomic<float>* enabled = nullptr; // nullptr for the first lane, which is always on
+        std::atomic<float>* noteDur = nullptr;
+        std::atomic<float>* noteDurSync = nullptr;
+        std::atomic<float>* randomize = nullptr;
+        std::atomic<float>* density = nullptr;
+        std::atomic<float>* pattern = nullptr;
+    };
+
+    juce::AudioProcessor& processor;
+
+    // Atomic param ptrs from the APVTS
+    std::array<LaneParameters, ParameterSnapshot::numLanes> laneParams;
+    std::atomic<float>* width;
+    std::atomic<float>* octaves;
+    std::atomic<float>* sync;
+    std::atomic<float>* swing;
+    std::atomic<float>* gain;
+    std::atomic<float>* osc;
+    std::array<std::atomic<float>*, 5> adsr;
+    std::atomic<float>* delay;
+    std::atomic<float>* hold;
+    std::atomic<float>* envLoop;
+    std::atomic<float>* polyphony;
+    std::atomic<float>* midiOnly;
+
+    std::atomic<uint32_t> changeCount { 1 };
+    uint32_t builtChangeCount = 0;
+
+    double sampleRate = 44100.0;
+    ParameterSnapshot snapshot;
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterPublisher)
+};
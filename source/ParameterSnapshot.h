@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "ADSR.h"
+#include "ArpPattern.h"
+
+//==============================================================================
+/**
+Plain copy of every parameter the audio thread reads, with the values derived
+from them (step lengths in samples and ticks, octave count, envelope
+parameters) already worked out.
+
+ParameterPublisher rebuilds it at the start of a block only when a parameter
+has changed, the arp and the synth engine then read it for the whole block
+instead of loading atomics.
+*/
+struct ParameterSnapshot
+{
+    static constexpr int numLanes = 4;
+
+    struct Lane
+    {
+        bool enabled = true;
+        int noteDurSamples = 1; // free-running step length
+        int64_t stepTicks = 0; // tempo-synced step length, see TransportClock
+        float randomize = 0.0f;
+        float density = 1.0f;
+        ArpPattern::Mode pattern = ArpPattern::Mode::up;
+    };
+
+    // Arpeggiator
+    std::array<Lane, numLanes> lanes;
+    float width = 0.0f;
+    int numOctaves = 1;
+    bool sync = false;
+    float swing = 0.0f;
+
+    // Synth
+    float gain = 0.5f;
+    int waveform = 0;
+    ADSR::Parameters envelope;
+    int polyphony = 8;
+    bool midiOnly = false;
+
+    // Increases every time the snapshot is rebuilt, so readers can tell when something changed
+    uint32_t version = 0;
+};
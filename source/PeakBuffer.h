@@ -0,0 +1,154 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+Feeds the waveform display from the audio thread without locks.
+
+The audio thread calls push() with each output block. It reduces every
+samplesPerPeak samples to the min and max of each channel and writes them to
+a single-producer single-consumer ring. The GUI thread pulls the newest peaks
+with read(). Neither side ever waits for the other: the writer overwrites the
+oldest peaks when the reader falls behind, and the reader drops any peaks the
+writer lapped while they were being copied. The ring's values are relaxed
+atomics, so a peak being overwritten while it is copied is a torn value
+that gets dropped rather than a data race.
+
+The display switches the feed on with setActive() only while it is showing,
+so without an open editor push() costs one relaxed atomic load.
+*/
+class PeakBuffer
+{
+public:
+    static constexpr int numChannels = 2;
+    static constexpr int capacity = 1024; // power of two, so indices wrap with a mask
+    static constexpr int samplesPerPeak = 128;
+
+    struct Peak
+    {
+        std::array<float, numChannels> min {};
+        std::array<float, numChannels> max {};
+    };
+
+    /** Turns the feed on or off. Called by the display when it becomes visible or hidden. */
+    void setActive (bool shouldBeActive) noexcept { active.store (shouldBeActive, std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Adds a block of audio to the feed. Call on the audio thread only.
+
+    Mono buffers show the same signal on both channels.
+    */
+    void push (const juce::AudioBuffer<float>& buffer) noexcept
+    {
+        if (! active.load (std::memory_order_relaxed) || buffer.getNumChannels() == 0)
+            return;
+
+        const int numSamples = buffer.getNumSamples();
+
+        for (int start = 0; start < numSamples;)
+        {
+            const int num = juce::jmin (numSamples - start, samplesPerPeak - pendingSamples);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto range = juce::FloatVectorOperations::findMinAndMax (buffer.getReadPointer (juce::jmin (ch, buffer.getNumChannels() - 1), start), num);
+
+                pending.min[(size_t) ch] = pendingSamples == 0 ? range.getStart() : juce::jmin (pending.min[(size_t) ch], range.getStart());
+                pending.max[(size_t) ch] = pendingSamples == 0 ? range.getEnd() : juce::jmax (pending.max[(size_t) ch], range.getEnd());
+            }
+
+            pendingSamples += num;
+            start += num;
+
+            if (pendingSamples == samplesPerPeak)
+            {
+                auto index = writeIndex.load (std::memory_order_relaxed);
+
+                // Pairs with the fence in read(): a reader that sees any of these values also sees writeIndex == index
+                std::atomic_thread_fence (std::memory_order_release);
+                peaks[index & mask].store (pending);
+
+                writeIndex.store (index + 1, std::memory_order_release);
+
+                pendingSamples = 0;
+            }
+        }
+    }
+
+    //==============================================================================
+    /** Copies the peaks written since the last call to dest, oldest first, and returns how many there were.
+
+    At most maxPeaks are returned; if more arrived, only the newest are kept.
+    Call on a single reader thread only.
+    */
+    int read (Peak* dest, int maxPeaks) noexcept
+    {
+        auto end = writeIndex.load (std::memory_order_acquire);
+
+        // Older peaks may be overwritten while they are copied, leave the writer half the ring as a margin
+        auto num = juce::jmin ((int) (end - readIndex), maxPeaks, capacity / 2);
+        auto first = end - (uint32_t) num;
+
+        for (auto i = first; i != end; ++i)
+            dest[i - first] = peaks[i & mask].load();
+
+        // The writer may have lapped the oldest copies meanwhile (and be writing the next slot), drop those.
+        // The fence keeps the copies above from being read after writeIndex.
+        std::atomic_thread_fence (std::memory_order_acquire);
+        auto oldestIntact = writeIndex.load (std::memory_order_relaxed) - (uint32_t) (capacity - 1);
+
+        if ((int32_t) (oldestIntact - first) > 0)
+        {
+            auto numTorn = juce::jmin (num, (int) (oldestIntact - first));
+            std::copy (dest + numTorn, dest + num, dest);
+            num -= numTorn;
+        }
+
+        readIndex = end;
+        return num;
+    }
+
+private:
+    static constexpr uint32_t mask = capacity - 1;
+
+    // A ring entry, written by the audio thread while the reader may be copying it
+    struct Slot
+    {
+        std::array<std::atomic<float>, numChannels> min {};
+        std::array<std::atomic<float>, numChannels> max {};
+
+        void store (const Peak& peak) noexcept
+        {
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                min[ch].store (peak.min[ch], std::memory_order_relaxed);
+                max[ch].store (peak.max[ch], std::memory_order_relaxed);
+            }
+        }
+
+        Peak load() const noexcept
+        {
+            Peak peak;
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                peak.min[ch] = min[ch].load (std::memory_order_relaxed);
+                peak.max[ch] = max[ch].load (std::memory_order_relaxed);
+            }
+
+            return peak;
+        }
+    };
+
+    std::array<Slot, capacity> peaks;
+    std::atomic<uint32_t> writeIndex { 0 };
+    std::atomic<bool> active { false };
+
+    // Audio thread only: the peak being accumulated and how many samples it covers
+    Peak pending;
+    int pendingSamples = 0;
+
+    // Reader only
+    uint32_t readIndex = 0;
+};
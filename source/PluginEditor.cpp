@@ -61,17 +61,43 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     oscLabel.attachToComponent (&oscSelector, false);
     addAndMakeVisible (oscLabel);
 
+    // The MIDI effect build never renders audio, so it has no MIDI-only toggle and no waveform to show
+   #if ! JucePlugin_IsMidiEffect
+    // MIDI-only toggle
+    midiOnlyButton.setColour (juce::ToggleButton::textColourId, juce::Colours::white);
+    addAndMakeVisible (midiOnlyButton);
+   #endif
+
+    // Polyphony
+    polyphonySlider.setSliderStyle (juce::Slider::IncDecButtons);
+    polyphonySlider.setTextBoxStyle (juce::Slider::TextBoxLeft, false, 40, 20);
+    addAndMakeVisible (polyphonySlider);
+
+    polyphonyLabel.setFont (juce::Font (16.0f, juce::Font::bold));
+    polyphonyLabel.setText ("Voices", juce::dontSendNotification);
+    polyphonyLabel.setColour (juce::Label::textColourId, juce::Colours::white);
+    polyphonyLabel.attachToComponent (&polyphonySlider, false);
+    addAndMakeVisible (polyphonyLabel);
+
+   #if ! JucePlugin_IsMidiEffect
     // Waveform
-    addAndMakeVisible (processorRef.waveform);
+    waveformView = std::make_unique<WaveformView> (processorRef.getWaveformPeaks());
+    addAndMakeVisible (*waveformView);
     juce::LookAndFeel& defaultLookAndFeel = juce::LookAndFeel::getDefaultLookAndFeel();
-    processorRef.waveform.setColours (defaultLookAndFeel.findColour (juce::Slider::backgroundColourId), defaultLookAndFeel.findColour (juce::Slider::thumbColourId));
-    processorRef.waveform.setRepaintRate (30);
-    processorRef.waveform.setBufferSize (512);
+    waveformView->setColours (defaultLookAndFeel.findColour (juce::Slider::backgroundColourId), defaultLookAndFeel.findColour (juce::Slider::thumbColourId));
+   #endif
+
+    // Light up the keys the host plays
+    processorRef.getKeyboardBridge().setDisplayActive (true);
+    startTimerHz (30);
 
-    
     // Initialize attachments
     gainSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (state, "gain", gainSlider);
     oscSelectorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (state, "osc", oscSelector);
+   #if ! JucePlugin_IsMidiEffect
+    midiOnlyButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (state, "midiOnly", midiOnlyButton);
+   #endif
+    polyphonySliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (state, "polyphony", polyphonySlider);
     
     // Use native title bar
     //auto* topLevel = juce::TopLevelWindow::getTopLevelWindow (0);
@@ -83,6 +109,7 @@ PluginEditor::PluginEditor (PluginProcessor& p)
 
 PluginEditor::~PluginEditor()
 {
+    processorRef.getKeyboardBridge().setDisplayActive (false);
 }
 
 void PluginEditor::paint (juce::Graphics& g)
@@ -97,6 +124,11 @@ void PluginEditor::paint (juce::Graphics& g)
     g.drawText ("RARP", 0, 30, getWidth(), getHeight(), juce::Justification::centredTop, false);
 }
 
+void PluginEditor::timerCallback()
+{
+    processorRef.getKeyboardBridge().updateDisplay();
+}
+
 void PluginEditor::resized()
 {
     // layout the positions of your child components here
@@ -122,13 +154,22 @@ void PluginEditor::resized()
     gainSlider.setBounds (40, 50, 40, height / 4);
 
     oscSelector.setBounds (width / 6, 50, 100, 20);
+   #if ! JucePlugin_IsMidiEffect
+    midiOnlyButton.setBounds (oscSelector.getRight() + 20, 45, 110, 30);
+   #endif
+
+    polyphonySlider.setBounds (width - 300, 50, 100, 20);
 
     const int waveformX = 60;
     const int waveformY = 260;
     const int waveformWidth = 300;
     const int waveformHeight = 200;
 
-    processorRef.waveform.setBounds (waveformX, waveformY, waveformWidth, waveformHeight);
+   #if ! JucePlugin_IsMidiEffect
+    waveformView->setBounds (waveformX, waveformY, waveformWidth, waveformHeight);
+   #else
+    juce::ignoreUnused (waveformHeight);
+   #endif
 
     arpeggiatorComponent->setBounds (waveformX + waveformWidth, waveformY, width - (waveformX + waveformWidth), height - waveformY);
 }
\ No newline at end of file
@@ -6,9 +6,10 @@
 
 #include "ADSRComponent.h"
 #include "ArpeggiatorComponent.h"
+#include "WaveformView.h"
 
 //==============================================================================
-class PluginEditor : public juce::AudioProcessorEditor
+class PluginEditor : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     explicit PluginEditor (PluginProcessor& p);
@@ -19,6 +20,8 @@ public:
     void resized() override;
 
 private:
+    void timerCallback() override;
+
     PluginProcessor& processorRef;
 
     std::unique_ptr<melatonin::Inspector> inspector;
@@ -34,12 +37,27 @@ private:
 
     std::unique_ptr<ArpeggiatorComponent> arpeggiatorComponent;
 
+   #if ! JucePlugin_IsMidiEffect
+    std::unique_ptr<WaveformView> waveformView;
+   #endif
+
     juce::ComboBox oscSelector;
     juce::Label oscLabel;
 
+   #if ! JucePlugin_IsMidiEffect
+    juce::ToggleButton midiOnlyButton { "MIDI Only" };
+   #endif
+
+    juce::Slider polyphonySlider;
+    juce::Label polyphonyLabel;
+
     // Attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oscSelectorAttachment;
+   #if ! JucePlugin_IsMidiEffect
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> midiOnlyButtonAttachment;
+   #endif
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> polyphonySliderAttachment;
 
     juce::UndoManager& undoManager;
     juce::MidiKeyboardComponent midiKeyboard;
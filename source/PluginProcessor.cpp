@@ -1,6 +1,5 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "SynthVoice.h"
 
 //==============================================================================
 PluginProcessor::PluginProcessor()
@@ -14,26 +13,9 @@ PluginProcessor::PluginProcessor()
               ),
       state (*this, &undoManager, "parameters", createParameters())
 {
-    // Initialize atomic param ptrs
-    std::atomic<float>* gainAtomic = state.getRawParameterValue ("gain");
-    std::array<std::atomic<float>*, 5> adsrAtomic = {
-        state.getRawParameterValue ("attack"),
-        state.getRawParameterValue ("decay"),
-        state.getRawParameterValue ("sustain"),
-        state.getRawParameterValue ("release"),
-        state.getRawParameterValue ("expo")
-    };
-    std::atomic<float>* oscAtomic = state.getRawParameterValue ("osc");
-    
-    synth.addSound (new SynthSound());
-
-    const int numSynthVoices = 8;
-
-    for (int i = 0; i < numSynthVoices; ++i)
-        synth.addVoice (new SynthVoice (gainAtomic, adsrAtomic, oscAtomic));
-
-    //waveform.setBufferSize(64);
-    waveform.setSamplesPerBlock(128);
+    // Fresh instances get a random arp seed, saved states restore theirs in setStateInformation()
+    arp.setSeed (static_cast<juce::uint32> (juce::Random::getSystemRandom().nextInt()));
+    state.state.setProperty ("seed", static_cast<int> (arp.getSeed()), nullptr);
 }
 
 PluginProcessor::~PluginProcessor()
@@ -108,30 +90,16 @@ void PluginProcessor::changeProgramName (int index, const juce::String& newName)
 //==============================================================================
 void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Prepare synth
-    synth.setCurrentPlaybackSampleRate (sampleRate);
-
-    // Prepare arpeggiator
-    arp.prepareToPlay (sampleRate,
-        state.getRawParameterValue ("noteDur"),
-        state.getRawParameterValue ("noteDurSync"),
-        state.getRawParameterValue ("randomize"),
-        state.getRawParameterValue ("density"),
-        state.getRawParameterValue ("width"),
-        &pan,
-        state.getRawParameterValue ("ascending"),
-        state.getRawParameterValue ("sync")
-    );
-
-    // Prepare synth voices
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-    {
-        auto voice = dynamic_cast<SynthVoice*> (synth.getVoice (i));
-        if (voice)
-        {
-            voice->prepareToPlay (sampleRate, samplesPerBlock, getTotalNumOutputChannels());
-        }
-    }
+    // Parameter values derived from the sample rate are rebuilt for it
+    parameters.prepare (sampleRate);
+
+    // Prepare synth and its voices
+    synth.prepareToPlay (sampleRate, parameters.getSnapshot());
+
+    // Prepare arpeggiator, with room for every event a block can hold
+    arp.prepareToPlay (sampleRate, samplesPerBlock);
+    arpEvents.prepare (Arpeggiator::getMaxEventsPerBlock (sampleRate, samplesPerBlock));
+    arpMidi.ensureSize ((size_t) (arpEvents.getCapacity() * KeyboardBridge::midiBufferBytesPerEvent));
 }
 
 void PluginProcessor::releaseResources()
@@ -167,6 +135,9 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 {
     juce::ignoreUnused (midiMessages);
 
+    // Lets test builds report any allocation or lock on the audio thread, see RealtimeCheck.h
+    const RealtimeCheck::ScopedRealtimeSection realtimeSection;
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -184,36 +155,59 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 
     int numSamples = buffer.getNumSamples();
 
-    // Process MIDI messages
-    keyboardState.processNextMidiBuffer (midiMessages, 0, numSamples, true);
+    // The host's notes and the ones played on the on-screen keyboard
+    const auto& midiInput = keyboardBridge.processNextMidiBuffer (midiMessages);
 
-    // Process arpeggiator
-    auto posInfo = getPlayHead()->getPosition();
+    // Everything below reads the parameters from this snapshot, rebuilt only when one has changed
+    const auto& params = parameters.update();
 
-    arp.processBlock (buffer, midiMessages, posInfo);
+    // Process arpeggiator, without a playhead (offline rendering, some hosts) it free-runs
+    juce::Optional<juce::AudioPlayHead::PositionInfo> posInfo;
 
-    // Process synth block
-    synth.renderNextBlock (buffer, midiMessages, 0, numSamples);
+    if (auto* playHead = getPlayHead())
+        posInfo = playHead->getPosition();
 
-    // Pan output
-    float panVal = pan.load();
+    arp.processBlock (numSamples, midiInput, posInfo, params, arpEvents);
 
-    if (panVal != 0.0f)
-    {
-        //auto* leftChannel = buffer.getWritePointer (0);
-        //auto* rightChannel = buffer.getWritePointer (1);
-        float leftGain = std::cos (0.5 * (pan + 1.0) * 0.5 * juce::MathConstants<float>::pi);
-        float rightGain = std::sin (0.5 * (pan + 1.0) * 0.5 * juce::MathConstants<float>::pi);
+    // The arp's notes replace the input in midiMessages, which goes to the host's MIDI output.
+    // They are written to arpMidi, whose storage is allocated in prepareToPlay(), and swapped in,
+    // so the host's buffer is never grown here. Whichever of the two buffers has more room is
+    // the one written to, the other one goes to the host.
+    if (midiMessages.data.getNumAllocated() > arpMidi.data.getNumAllocated())
+        midiMessages.swapWith (arpMidi);
+
+    arpMidi.clear();
+
+    for (const auto& event : arpEvents)
+        arpMidi.addEvent (event.toMidiMessage(), event.offset);
 
-        buffer.applyGainRamp (0, 0, numSamples, prevLeftGain, leftGain);
-        buffer.applyGainRamp (1, 0, numSamples, prevRightGain, rightGain);
+    midiMessages.swapWith (arpMidi);
 
-        prevLeftGain = leftGain;
-        prevRightGain = rightGain;
+    // In MIDI-only mode the arp's output in midiMessages goes straight to the host,
+    // voice rendering and the visualizer are skipped entirely
+   #if JucePlugin_IsMidiEffect
+    const bool renderAudio = false;
+   #else
+    const bool renderAudio = ! params.midiOnly;
+   #endif
+
+    if (! renderAudio)
+    {
+        // Silence any voices left over from before MIDI-only mode was switched on
+        if (renderingAudio)
+            synth.allNotesOff (false);
+
+        renderingAudio = false;
+        return;
     }
 
-    waveform.pushBuffer (buffer);
-    
+    renderingAudio = true;
+
+    // Process synth block
+    synth.renderNextBlock (buffer, arpEvents, params);
+
+    // Only does work while the editor's waveform view is showing
+    waveformPeaks.push (buffer);
 }
 
 //==============================================================================
@@ -239,8 +233,41 @@ void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
     if (xmlState.get() != nullptr)
+    {
         if (xmlState->hasTagName (state.state.getType()))
-            state.replaceState (juce::ValueTree::fromXml (*xmlState));
+        {
+            auto newState = juce::ValueTree::fromXml (*xmlState);
+            migrateLegacyState (newState);
+            state.replaceState (newState);
+        }
+    }
+
+    // Restore the arp's seed so renders of this state are reproducible (states saved without one keep the current seed)
+    if (! state.state.hasProperty ("seed"))
+        state.state.setProperty ("seed", static_cast<int> (arp.getSeed()), nullptr);
+
+    arp.setSeed (static_cast<juce::uint32> (static_cast<int> (state.state.getProperty ("seed"))));
+}
+
+void PluginProcessor::migrateLegacyState (juce::ValueTree& stateTree)
+{
+    // Before the pattern choice the arp had an "ascending" toggle, switching it off played the notes downwards
+    auto ascending = stateTree.getChildWithProperty ("id", "ascending");
+
+    if (! ascending.isValid())
+        return;
+
+    if (! stateTree.getChildWithProperty ("id", "pattern").isValid())
+    {
+        auto mode = static_cast<float> (ascending.getProperty ("value")) >= 0.5f ? ArpPattern::Mode::up : ArpPattern::Mode::down;
+
+        juce::ValueTree pattern ("PARAM");
+        pattern.setProperty ("id", "pattern", nullptr);
+        pattern.setProperty ("value", static_cast<int> (mode), nullptr);
+        stateTree.appendChild (pattern, nullptr);
+    }
+
+    stateTree.removeChild (ascending, nullptr);
 }
 
 //==============================================================================
@@ -266,6 +293,17 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
     ));
 
     // ADSR params
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        juce::ParameterID { "delay" },
+        "Delay",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.001, 0.5),
+        0.0f,
+        "",
+        juce::AudioProcessorParameter::genericParameter,
+        &msValueToTextFunction,
+        &msTextToValueFunction
+    ));
+
     params.push_back (std::make_unique<juce::AudioParameterFloat> (
         juce::ParameterID { "attack" },
         "Attack",
@@ -277,6 +315,17 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
         &msTextToValueFunction
     ));
 
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        juce::ParameterID { "hold" },
+        "Hold",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.001, 0.5),
+        0.0f,
+        "",
+        juce::AudioProcessorParameter::genericParameter,
+        &msValueToTextFunction,
+        &msTextToValueFunction
+    ));
+
     params.push_back (std::make_unique<juce::AudioParameterFloat> (
         juce::ParameterID { "decay" },
         "Decay",
@@ -314,38 +363,78 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
         0.1f
     ));
 
-    params.push_back (std::make_unique<juce::AudioParameterFloat> (
-        juce::ParameterID { "noteDur" },
-        "Note Duration",
-        juce::NormalisableRange<float> (0.001f, 3.0f, 0.001, 0.3),
-        0.1f,
-        "",
-        juce::AudioProcessorParameter::genericParameter,
-        &msValueToTextFunction,
-        &msTextToValueFunction
+    // Repeat attack, hold and decay while a note is held
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        juce::ParameterID { "envLoop" },
+        "Envelope Loop",
+        false
     ));
 
-    params.push_back (std::make_unique<juce::AudioParameterChoice> (
-        juce::ParameterID { "noteDurSync" },
-        "Note Duration",
-        juce::StringArray { "1/128 note", "1/64 note", "1/32 note", "1/16 note", "1/8 note", "1/4 note", "1/2 note" },
-        5
+    // Number of voices that can sound at once
+    params.push_back (std::make_unique<juce::AudioParameterInt> (
+        juce::ParameterID { "polyphony" },
+        "Polyphony",
+        SynthEngine::minPolyphony,
+        SynthEngine::maxPolyphony,
+        32
     ));
 
-    params.push_back (std::make_unique<juce::AudioParameterFloat> (
-        juce::ParameterID { "randomize" },
-        "Randomize",
-        0.0f,
-        1.0f,
-        0.0f
-    ));
+    // Arpeggiator lane params, the first lane uses the unsuffixed IDs
+    for (int lane = 0; lane < Arpeggiator::maxLanes; ++lane)
+    {
+        auto laneID = [lane] (const juce::String& paramID) { return juce::ParameterID { Arpeggiator::getLaneParamID (paramID, lane) }; };
+        auto laneName = [lane] (const juce::String& name) { return lane == 0 ? name : "Lane " + juce::String (lane + 1) + " " + name; };
 
-    params.push_back (std::make_unique<juce::AudioParameterFloat> (
-        juce::ParameterID { "density" },
-        "Density",
-        0.0f,
-        1.0f,
-        1.0f));
+        if (lane > 0)
+        {
+            params.push_back (std::make_unique<juce::AudioParameterBool> (
+                laneID ("laneOn"),
+                laneName ("On"),
+                false
+            ));
+        }
+
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (
+            laneID ("noteDur"),
+            laneName ("Note Duration"),
+            juce::NormalisableRange<float> (Arpeggiator::minNoteDuration, 3.0f, 0.001, 0.3),
+            0.1f,
+            "",
+            juce::AudioProcessorParameter::genericParameter,
+            &msValueToTextFunction,
+            &msTextToValueFunction
+        ));
+
+        params.push_back (std::make_unique<juce::AudioParameterChoice> (
+            laneID ("noteDurSync"),
+            laneName ("Note Duration"),
+            juce::StringArray { "1/128 note", "1/64 note", "1/32 note", "1/16 note", "1/8 note", "1/4 note", "1/2 note" },
+            5
+        ));
+
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (
+            laneID ("randomize"),
+            laneName ("Randomize"),
+            0.0f,
+            1.0f,
+            0.0f
+        ));
+
+        params.push_back (std::make_unique<juce::AudioParameterFloat> (
+            laneID ("density"),
+            laneName ("Density"),
+            0.0f,
+            1.0f,
+            1.0f
+        ));
+
+        params.push_back (std::make_unique<juce::AudioParameterChoice> (
+            laneID ("pattern"),
+            laneName ("Pattern"),
+            ArpPattern::getModeNames(),
+            0
+        ));
+    }
 
     params.push_back (std::make_unique<juce::AudioParameterFloat> (
         juce::ParameterID { "width" },
@@ -355,10 +444,11 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
         0.0f
     ));
 
-    params.push_back (std::make_unique<juce::AudioParameterBool> (
-        juce::ParameterID { "ascending" },
-        "Ascending",
-        true
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        juce::ParameterID { "octaves" },
+        "Octaves",
+        juce::StringArray { "1 oct", "2 oct", "3 oct", "4 oct" },
+        0
     ));
 
     params.push_back (std::make_unique<juce::AudioParameterBool> (
@@ -367,6 +457,20 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
         false
     ));
 
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        juce::ParameterID { "swing" },
+        "Swing",
+        0.0f,
+        1.0f,
+        0.0f
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        juce::ParameterID { "midiOnly" },
+        "MIDI Only",
+        false
+    ));
+
     return { params.begin(), params.end() };
 }
 
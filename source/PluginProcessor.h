@@ -5,6 +5,11 @@
 #include <juce_audio_utils/juce_audio_utils.h>
 
 #include "Arpeggiator.h"
+#include "KeyboardBridge.h"
+#include "ParameterPublisher.h"
+#include "PeakBuffer.h"
+#include "RealtimeCheck.h"
+#include "SynthEngine.h"
 
 #if (MSVC)
 #include "ipps.h"
@@ -46,8 +51,8 @@ public:
     juce::AudioProcessorValueTreeState& getState() { return state; }
     juce::UndoManager& getUndoManager() { return undoManager; }
     juce::MidiKeyboardState& getMidiKeyboardState() { return keyboardState; }
-
-    juce::AudioVisualiserComponent waveform { 2 };
+    KeyboardBridge& getKeyboardBridge() { return keyboardBridge; }
+    PeakBuffer& getWaveformPeaks() { return waveformPeaks; }
 
 private:
     static juce::String msValueToTextFunction (float value, int maximumStringLength)
@@ -65,17 +70,30 @@ private:
 
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
+    // Rewrites parameters of older saved states as the ones that replaced them
+    static void migrateLegacyState (juce::ValueTree& stateTree);
+
     juce::AudioProcessorValueTreeState state;
     juce::UndoManager undoManager;
 
-    juce::Synthesiser synth;
+    SynthEngine synth;
 
     Arpeggiator arp;
-    std::atomic<float> pan { 0.0f }; // from -1.0 (left) to 1.0 (right)
-    float prevLeftGain { 0 };
-    float prevRightGain { 0 };
+    ArpEventList arpEvents; // the notes the arp plays in the current block
+    juce::MidiBuffer arpMidi; // the same notes as MIDI, swapped into processBlock's buffer
+
+    // Builds the per-block parameter snapshot, after state so every parameter exists
+    ParameterPublisher parameters { state };
 
+    // MIDI-only mode: output the arp's MIDI without rendering any audio
+    bool renderingAudio = true;
+
+    // The on-screen keyboard, whose notes reach the audio thread through the bridge
     juce::MidiKeyboardState keyboardState;
+    KeyboardBridge keyboardBridge { keyboardState };
+
+    // Output peaks for the editor's waveform display
+    PeakBuffer waveformPeaks;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginProcessor)
 };
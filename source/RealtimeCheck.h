@@ -0,0 +1,31 @@
+#pragma once
+
+//==============================================================================
+/**
+Marks the code that must be real-time safe, for the tests' checker.
+
+processBlock() opens a ScopedRealtimeSection for its whole body. Builds with
+RARP_REALTIME_CHECKS (the Tests target) link in tests/helpers/RealtimeChecker,
+which reports every allocation, free and mutex lock made on a thread while it
+is inside a section. In every other build the section is empty and compiles away.
+*/
+namespace RealtimeCheck
+{
+#if RARP_REALTIME_CHECKS
+    // Defined by the checker
+    void enterSection() noexcept;
+    void exitSection() noexcept;
+#else
+    inline void enterSection() noexcept {}
+    inline void exitSection() noexcept {}
+#endif
+
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection() noexcept { enterSection(); }
+        ~ScopedRealtimeSection() { exitSection(); }
+
+        ScopedRealtimeSection (const ScopedRealtimeSection&) = delete;
+        ScopedRealtimeSection& operator= (const ScopedRealtimeSection&) = delete;
+    };
+}
@@ -0,0 +1,322 @@
+#include "SynthEngine.h"
+
+void SynthEngine::prepareToPlay (double sampleRate, const ParameterSnapshot& params)
+{
+    bank.prepare (sampleRate);
+
+    for (auto& voice : voices)
+        voice.prepareToPlay (sampleRate);
+
+    envelopes.assign ((size_t) (maxChunkSize * VoiceBank::groupSize), 0.0f);
+    mixLeft.assign ((size_t) maxChunkSize, 0.0f);
+    mixRight.assign ((size_t) maxChunkSize, 0.0f);
+    gainRamp.assign ((size_t) maxChunkSize, 0.0f);
+    crossfadeRamp.assign ((size_t) maxChunkSize, 0.0f);
+
+    pendingNotes.fill ({});
+    numPending = 0;
+
+    gain.reset (sampleRate, 0.01);
+    gain.setCurrentAndTargetValue (params.gain);
+
+    waveform = targetWaveform = params.waveform;
+    bank.resetWaveform (waveform);
+    waveformCrossfade.reset (sampleRate, 0.02);
+    waveformCrossfade.setCurrentAndTargetValue (1.0f);
+
+    parameterVersion = params.version - 1;
+    applyParameters (params);
+}
+
+void SynthEngine::setPolyphony (int numVoices)
+{
+    numVoices = juce::jlimit (minPolyphony, maxPolyphony, numVoices);
+
+    // Voices above the new limit fade out rather than cut off, and are rendered until they have
+    for (int i = numVoices; i < polyphony; ++i)
+    {
+        voices[(size_t) i].fadeOut();
+
+        // A note waiting for a trimmed voice is dropped
+        if (pendingNotes[(size_t) i].note >= 0)
+        {
+            pendingNotes[(size_t) i].note = -1;
+            --numPending;
+        }
+    }
+
+    numVoicesToRender = juce::jmax (numVoicesToRender, numVoices);
+    polyphony = numVoices;
+}
+
+void SynthEngine::allNotesOff (bool allowTailOff)
+{
+    for (auto& voice : voices)
+        if (voice.isActive())
+            voice.stopNote (allowTailOff);
+
+    pendingNotes.fill ({});
+    numPending = 0;
+}
+
+//==============================================================================
+void SynthEngine::renderNextBlock (juce::AudioBuffer<float>& outputAudio, const ArpEventList& events, const ParameterSnapshot& params)
+{
+    applyParameters (params);
+
+    // Render up to each event, then apply it (events are sorted by offset)
+    int position = 0;
+
+    for (const auto& event : events)
+    {
+        auto offset = juce::jlimit (position, outputAudio.getNumSamples(), event.offset);
+
+        if (offset > position)
+            renderVoices (outputAudio, position, offset - position);
+
+        handleEvent (event);
+        position = offset;
+    }
+
+    if (position < outputAudio.getNumSamples())
+        renderVoices (outputAudio, position, outputAudio.getNumSamples() - position);
+}
+
+void SynthEngine::applyParameters (const ParameterSnapshot& params)
+{
+    // Nothing to do unless the snapshot was rebuilt since the last block
+    if (params.version == parameterVersion)
+        return;
+
+    parameterVersion = params.version;
+
+    gain.setTargetValue (params.gain);
+
+    targetWaveform = params.waveform;
+    startWaveformChange();
+
+    // Voices already exist, so a changed voice count only limits (or frees up) the ones in use
+    if (params.polyphony != polyphony)
+        setPolyphony (params.polyphony);
+
+    for (auto& voice : voices)
+        voice.setEnvelopeParameters (params.envelope);
+}
+
+void SynthEngine::startWaveformChange()
+{
+    // Restarting a running crossfade would jump from its current mix to all of the old waveform,
+    // so a change waits until the fade is over. renderVoices() calls this again before every chunk.
+    if (targetWaveform == waveform || waveformCrossfade.isSmoothing())
+        return;
+
+    waveform = targetWaveform;
+    bank.setWaveform (waveform);
+
+    waveformCrossfade.setCurrentAndTargetValue (0.0f);
+    waveformCrossfade.setTargetValue (1.0f);
+}
+
+void SynthEngine::handleEvent (const ArpEvent& event)
+{
+    if (event.isNoteOn())
+        noteOn (event.channel, event.note, event.pan);
+    else
+        noteOff (event.channel, event.note);
+}
+
+void SynthEngine::noteOn (int midiChannel, int midiNoteNumber, float pan)
+{
+    // A retriggered note fades out its old voice rather than stacking a second one
+    noteOff (midiChannel, midiNoteNumber);
+
+    int index = 0;
+
+    while (index < polyphony && voices[(size_t) index].isActive())
+        ++index;
+
+    if (index < polyphony)
+    {
+        startVoice (index, midiChannel, midiNoteNumber, pan);
+        return;
+    }
+
+    // Cutting a voice off clicks, so the stolen one fades out and the note waits for its slot
+    index = findVoiceToSteal();
+    voices[(size_t) index].fadeOut();
+
+    auto& pending = pendingNotes[(size_t) index];
+
+    if (pending.note < 0)
+        ++numPending;
+
+    pending = { midiChannel, midiNoteNumber, pan, false };
+}
+
+void SynthEngine::noteOff (int midiChannel, int midiNoteNumber)
+{
+    for (int i = 0; i < polyphony; ++i)
+    {
+        auto& voice = voices[(size_t) i];
+
+        if (voice.isPlaying (midiChannel, midiNoteNumber) && ! voice.isReleasing())
+            voice.stopNote (true);
+
+        // A note still waiting for its voice will play its release as soon as it starts
+        auto& pending = pendingNotes[(size_t) i];
+
+        if (pending.note == midiNoteNumber && pending.channel == midiChannel)
+            pending.released = true;
+    }
+}
+
+void SynthEngine::startVoice (int index, int midiChannel, int midiNoteNumber, float pan)
+{
+    // No pitch glide, the mip level is picked for this note's pitch
+    bank.startVoice (index, juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber), 1.0f, pan);
+    voices[(size_t) index].startNote (midiChannel, midiNoteNumber);
+}
+
+int SynthEngine::getSamplesUntilNextHandover() const
+{
+    int samples = std::numeric_limits<int>::max();
+
+    if (numPending > 0)
+        for (int i = 0; i < polyphony; ++i)
+            if (pendingNotes[(size_t) i].note >= 0)
+                samples = juce::jmin (samples, juce::jmax (1, voices[(size_t) i].getFadeSamplesLeft()));
+
+    return samples;
+}
+
+void SynthEngine::startPendingNotes()
+{
+    for (int i = 0; i < polyphony && numPending > 0; ++i)
+    {
+        auto& pending = pendingNotes[(size_t) i];
+
+        if (pending.note < 0 || voices[(size_t) i].isActive())
+            continue;
+
+        startVoice (i, pending.channel, pending.note, pending.pan);
+
+        if (pending.released)
+            voices[(size_t) i].stopNote (true);
+
+        pending.note = -1;
+        --numPending;
+    }
+}
+
+int SynthEngine::findVoiceToSteal() const
+{
+    int quietest = 0;
+    float quietestScore = std::numeric_limits<float>::max();
+
+    for (int i = 0; i < polyphony; ++i)
+    {
+        const auto& voice = voices[(size_t) i];
+
+        // Voices already fading out without a note waiting rank first, then releasing voices before held ones,
+        // the quietest (furthest into its release) first. A voice another note is waiting for is a last resort.
+        auto score = voice.getEnvelopeLevel() + (voice.isReleasing() ? 0.0f : 2.0f);
+
+        if (pendingNotes[(size_t) i].note >= 0)
+            score += 4.0f;
+        else if (voice.isFadingOut())
+            score -= 2.0f;
+
+        if (score < quietestScore)
+        {
+            quietest = i;
+            quietestScore = score;
+        }
+    }
+
+    return quietest;
+}
+
+//==============================================================================
+void SynthEngine::renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    // A mono bus gets the voices summed unpanned, anything wider gets the stereo mix on its first two channels
+    const bool stereo = outputAudio.getNumChannels() > 1;
+
+    if (outputAudio.getNumChannels() == 0)
+        return;
+
+    while (numSamples > 0)
+    {
+        // Chunks end where a stolen voice has faded out, so the note waiting for it starts on time
+        auto chunkSize = juce::jmin (numSamples, maxChunkSize, getSamplesUntilNextHandover());
+        std::fill (mixLeft.begin(), mixLeft.begin() + chunkSize, 0.0f);
+
+        if (stereo)
+            std::fill (mixRight.begin(), mixRight.begin() + chunkSize, 0.0f);
+
+        // A waveform change that waited for the previous crossfade starts here
+        startWaveformChange();
+
+        // Per-sample parameter ramps for this chunk, the crossfade only while a waveform change is fading in
+        for (int i = 0; i < chunkSize; ++i)
+            gainRamp[(size_t) i] = gain.getNextValue();
+
+        const float* crossfade = nullptr;
+
+        if (waveformCrossfade.isSmoothing())
+        {
+            for (int i = 0; i < chunkSize; ++i)
+                crossfadeRamp[(size_t) i] = waveformCrossfade.getNextValue();
+
+            crossfade = crossfadeRamp.data();
+        }
+
+        for (int first = 0; first < numVoicesToRender; first += VoiceBank::groupSize)
+        {
+            bool groupActive = false;
+
+            for (int lane = 0; lane < VoiceBank::groupSize; ++lane)
+            {
+                auto& voice = voices[(size_t) (first + lane)];
+
+                if (first + lane < numVoicesToRender && voice.isActive())
+                {
+                    voice.renderEnvelope (envelopes.data() + lane, chunkSize, VoiceBank::groupSize);
+                    groupActive = true;
+                }
+                else
+                {
+                    // Silent lanes still go through the kernel, with a zero envelope
+                    for (int i = 0; i < chunkSize; ++i)
+                        envelopes[(size_t) (i * VoiceBank::groupSize + lane)] = 0.0f;
+                }
+            }
+
+            if (! groupActive)
+                continue;
+
+            if (stereo)
+                bank.renderGroup (first / VoiceBank::groupSize, envelopes.data(), crossfade, mixLeft.data(), mixRight.data(), chunkSize);
+            else
+                bank.renderGroupMono (first / VoiceBank::groupSize, envelopes.data(), crossfade, mixLeft.data(), chunkSize);
+        }
+
+        juce::FloatVectorOperations::multiply (mixLeft.data(), gainRamp.data(), chunkSize);
+        outputAudio.addFrom (0, startSample, mixLeft.data(), chunkSize);
+
+        if (stereo)
+        {
+            juce::FloatVectorOperations::multiply (mixRight.data(), gainRamp.data(), chunkSize);
+            outputAudio.addFrom (1, startSample, mixRight.data(), chunkSize);
+        }
+
+        startSample += chunkSize;
+        numSamples -= chunkSize;
+
+        startPendingNotes();
+
+        // Stop rendering trimmed voices once they have faded out
+        while (numVoicesToRender > polyphony && ! voices[(size_t) numVoicesToRender - 1].isActive())
+            --numVoicesToRender;
+    }
+}
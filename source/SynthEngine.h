@@ -0,0 +1,101 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "ArpEvent.h"
+#include "ParameterSnapshot.h"
+#include "SynthVoice.h"
+#include "VoiceBank.h"
+
+//==============================================================================
+/**
+RARP's voice engine, playing the arp's events on a flat array of voices.
+
+Everything runs on the audio thread: the block is rendered in segments
+between events from the pre-sorted ArpEventList, so there is no MIDI parsing
+and no lock. All maxPolyphony voices exist up front and setPolyphony()
+limits how many of them are used. When they are all busy, the quietest voice
+is stolen, preferring ones that are already releasing. A stolen voice fades
+out over a few milliseconds and the new note starts in its slot once it is
+silent; voices trimmed by a lower polyphony fade out the same way.
+
+Rendering: every voice writes its envelope into an interleaved scratch
+buffer, then each group of VoiceBank::groupSize voices is rendered in one
+vectorised pass. Voices stay mono until that sum, where they are placed in a
+stereo mix with their own pan (or summed unpanned for a mono bus). Gain is
+applied once to the mix, which is then added to the output.
+
+Parameter changes never jump: gain follows a per-sample ramp and a new
+waveform is crossfaded in from the old one. A waveform chosen while a
+crossfade is running waits for it to end, so each fade is between two
+waveforms. Both ramps are written into preallocated buffers a chunk at a time.
+*/
+class SynthEngine
+{
+public:
+    static constexpr int minPolyphony = 8;
+    static constexpr int maxPolyphony = VoiceBank::maxVoices;
+
+    void prepareToPlay (double sampleRate, const ParameterSnapshot& params);
+
+    /** Sets how many of the voices can play at once (minPolyphony to maxPolyphony), voices above the new limit fade out. */
+    void setPolyphony (int numVoices);
+
+    int getPolyphony() const noexcept { return polyphony; }
+
+    /** Stops every voice, letting them fade out if allowTailOff is true. */
+    void allNotesOff (bool allowTailOff);
+
+    /** Adds the voices' output for this block to buffer, applying each event at its offset. */
+    void renderNextBlock (juce::AudioBuffer<float>& outputAudio, const ArpEventList& events, const ParameterSnapshot& params);
+
+private:
+    void applyParameters (const ParameterSnapshot& params);
+    void handleEvent (const ArpEvent& event);
+    void noteOn (int midiChannel, int midiNoteNumber, float pan);
+    void noteOff (int midiChannel, int midiNoteNumber);
+    int findVoiceToSteal() const;
+    void startVoice (int index, int midiChannel, int midiNoteNumber, float pan);
+    int getSamplesUntilNextHandover() const;
+    void startPendingNotes();
+    void startWaveformChange();
+
+    void renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples);
+
+    VoiceBank bank;
+
+    // Voice i plays bank slot i
+    std::array<SynthVoice, maxPolyphony> voices;
+    int polyphony = minPolyphony; // voices in use, the first polyphony entries of voices
+    int numVoicesToRender = minPolyphony; // also covers trimmed voices above polyphony that are still fading out
+
+    // Notes waiting for their stolen voice to fade out, by slot
+    struct PendingNote
+    {
+        int channel = 0;
+        int note = -1; // -1 when nothing is waiting
+        float pan = 0.0f;
+        bool released = false; // the note-off came before the note could start
+    };
+
+    std::array<PendingNote, maxPolyphony> pendingNotes;
+    int numPending = 0;
+
+    // Scratch buffers, rendered in chunks of at most maxChunkSize samples
+    static constexpr int maxChunkSize = 256;
+    std::vector<float> envelopes; // maxChunkSize frames of VoiceBank::groupSize values
+    std::vector<float> mixLeft;
+    std::vector<float> mixRight;
+    std::vector<float> gainRamp;
+    std::vector<float> crossfadeRamp;
+
+    juce::SmoothedValue<float> gain;
+
+    // Weight of the current waveform against the previous one, ramps from 0 to 1 after a change
+    juce::SmoothedValue<float> waveformCrossfade;
+    int waveform = 0; // the waveform being faded to, or playing once the fade is over
+    int targetWaveform = 0; // the "osc" parameter, becomes waveform when no crossfade is running
+
+    // Version of the last parameter snapshot applied to the voices
+    uint32_t parameterVersion = 0;
+};
@@ -1,109 +1,76 @@
 #include "SynthVoice.h"
 
-SynthVoice::SynthVoice (std::atomic<float>* gainPtr, std::array<std::atomic<float>*, 5> adsrPtrs, std::atomic<float>* oscPtr)
-    : gainAtomic (gainPtr),
-      oscAtomic (oscPtr)
+void SynthVoice::prepareToPlay (double sampleRate)
 {
-    oscillators = {
-        // sine
-        juce::dsp::Oscillator<float> ([] (float x) { return std::sin (x); }),
-        // triangle
-        juce::dsp::Oscillator<float> ([] (float x) { return 2 / juce::MathConstants<float>::pi * std::asin (std::sin (x)); }),
-        // sawtooth
-        juce::dsp::Oscillator<float> ([] (float x) { return x / juce::MathConstants<float>::pi; }),
-        // square
-        juce::dsp::Oscillator<float> ([] (float x) { return x < 0.0f ? -1.0f : 1.0f; })
-    };
-    adsr.initialize (adsrPtrs);
+    adsr.setSampleRate (sampleRate);
+    adsr.reset();
+
+    fadeOutSamples = juce::jmax (1, static_cast<int> (fadeOutSeconds * sampleRate));
+    fadeSamplesLeft = 0;
+    currentNote = -1;
 }
 
 //==============================================================================
-
-bool SynthVoice::canPlaySound (juce::SynthesiserSound* sound)
+void SynthVoice::startNote (int midiChannel, int midiNoteNumber)
 {
-    return dynamic_cast<juce::SynthesiserSound*>(sound) != nullptr;
+    currentNote = midiNoteNumber;
+    currentChannel = midiChannel;
+    fadeSamplesLeft = 0;
+
+    adsr.noteOn();
 }
 
-void SynthVoice::startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound* sound, int currentPitchWheelPosition)
+void SynthVoice::stopNote (bool allowTailOff)
 {
-    auto freq = juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber);
-
-    // Force = true, no pitch glide
-    for (int i = 0; i < oscillators.size(); ++i)
+    if (allowTailOff)
     {
-        oscillators[i].setFrequency (freq, true);
-    }
+        adsr.noteOff();
 
-    adsr.noteOn();
-}
-void SynthVoice::stopNote(float velocity, bool allowTailOff)
-{
-    adsr.noteOff();
+        if (adsr.isActive())
+            return;
+    }
 
-    if (!allowTailOff || !adsr.isActive())
-        clearCurrentNote();
+    adsr.reset();
+    fadeSamplesLeft = 0;
+    currentNote = -1;
 }
 
-void SynthVoice::pitchWheelMoved(int newPitchWheelValue)
+void SynthVoice::fadeOut() noexcept
 {
-    //DBG (newPitchWheelValue);
-}
+    if (! isActive() || isFadingOut())
+        return;
 
-void SynthVoice::controllerMoved(int controllerNumber, int newControllerValue)
-{
-    return;
+    fadeSamplesLeft = fadeOutSamples;
+    fadeGain = 1.0f;
+    fadeStep = 1.0f / static_cast<float> (fadeOutSamples);
 }
 
-void SynthVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+void SynthVoice::renderEnvelope (float* dest, int numSamples, int stride)
 {
-    if (!isVoiceActive())
-        return;
-
-    voiceBuffer.setSize (outputBuffer.getNumChannels(), numSamples, false, false, true);
-    voiceBuffer.clear();
+    adsr.renderEnvelope (dest, numSamples, stride);
 
-    juce::dsp::AudioBlock<float> audioBlock { voiceBuffer };
-    juce::dsp::ProcessContextReplacing<float> context { audioBlock };
+    if (isFadingOut())
+    {
+        // Ramp down to 0 on the fade's last sample, silence after it
+        auto numFading = juce::jmin (numSamples, fadeSamplesLeft);
 
-    // This method does not work with polyphony
-    //auto subBlock = audioBlock.getSubBlock ((size_t) startSample, (size_t) numSamples);
-    //juce::dsp::ProcessContextReplacing<float> context { subBlock };
+        for (int i = 0; i < numFading; ++i)
+        {
+            fadeGain -= fadeStep;
+            dest[i * stride] *= juce::jmax (0.0f, fadeGain);
+        }
 
-    // Process oscillator
-    int oscIndex = static_cast<int> (oscAtomic->load());
-    oscillators[oscIndex].process (context);
-    
+        for (int i = numFading; i < numSamples; ++i)
+            dest[i * stride] = 0.0f;
 
-    // Get gain value from PluginProcessor's atomic float and apply
-    gain.setGainLinear (gainAtomic->load());
-    gain.process (context);
+        fadeSamplesLeft -= numFading;
 
-    // Apply ADSR Envelope
-    adsr.updateADSR();
-    adsr.applyEnvelopeToBuffer(voiceBuffer, 0, voiceBuffer.getNumSamples());
+        if (fadeSamplesLeft == 0)
+            stopNote (false);
 
-    // Add from per-voice voiceBuffer to outputBuffer from startSample
-    for (int i = 0; i < outputBuffer.getNumChannels(); ++i)
-        outputBuffer.addFrom (i, startSample, voiceBuffer, i, 0, numSamples);
+        return;
+    }
 
     if (!adsr.isActive())
-        clearCurrentNote();
+        currentNote = -1;
 }
-
-void SynthVoice::prepareToPlay (double sampleRate, int samplesPerBlock, int numOutputChannels)
-{
-    adsr.setSampleRate(sampleRate);
-
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = numOutputChannels;
-
-    for (int i = 0; i < oscillators.size(); ++i)
-    {
-        oscillators[i].prepare (spec);
-    }
-
-    gain.prepare (spec);
-    gain.setRampDurationSeconds (0.01);
-}
\ No newline at end of file
@@ -1,37 +1,63 @@
 #pragma once
 
-#include "SynthSound.h"
-#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
 
 #include "ADSR.h"
 
-class SynthVoice : public juce::SynthesiserVoice
+//==============================================================================
+/**
+Note and envelope state of one synth voice.
+
+Voices live in a flat array in SynthEngine, voice i's oscillator is slot i
+of the engine's VoiceBank. Everything here runs on the audio thread only.
+*/
+class SynthVoice
 {
 public:
-    SynthVoice (std::atomic<float>* gainPtr, std::array<std::atomic<float>*, 5> adsrPtrs, std::atomic<float>* oscPtr);
+    void prepareToPlay (double sampleRate);
 
-    bool canPlaySound (juce::SynthesiserSound* sound) override;
-    void startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound* sound, int currentPitchWheelPosition) override;
-    void stopNote (float velocity, bool allowTailOff) override;
-    void pitchWheelMoved (int newPitchWheelValue) override;
-    void controllerMoved (int controllerNumber, int newControllerValue) override;
-    void renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
-    void prepareToPlay (double sampleRate, int samplesPerBlock, int numOutputChannels);
+    /** Sets the envelope parameters, SynthEngine calls this when the parameter snapshot changes. */
+    void setEnvelopeParameters (const ADSR::Parameters& parameters) { adsr.setParameters (parameters); }
 
-private:
+    void startNote (int midiChannel, int midiNoteNumber);
+    void stopNote (bool allowTailOff);
 
-    // Per-voice audio buffer to be processed by this voice before being added to outputBuffer
-    // in renderNextBlock to prevent popping artifacts while supporting polyphony
-    juce::AudioBuffer<float> voiceBuffer;
+    /** Fades the voice out over fadeOutSeconds and then stops it, for voices that are stolen or trimmed. */
+    void fadeOut() noexcept;
 
-    ADSR adsr;
+    /** Returns true while the voice is fading out after fadeOut(). */
+    bool isFadingOut() const noexcept { return fadeSamplesLeft > 0; }
+
+    /** Returns the number of samples left until the fade-out ends and the voice is free. */
+    int getFadeSamplesLeft() const noexcept { return fadeSamplesLeft; }
+
+    /** Returns true while the voice is playing a note or fading out after one. */
+    bool isActive() const noexcept { return currentNote >= 0; }
+
+    /** Returns true if the voice was started by this note on this channel. */
+    bool isPlaying (int midiChannel, int midiNoteNumber) const noexcept { return currentNote == midiNoteNumber && currentChannel == midiChannel; }
 
-    // DSP modules
-    std::array<juce::dsp::Oscillator<float>, 4> oscillators;
+    /** Writes this voice's next numSamples envelope values to dest, stride floats apart, for SynthEngine's grouped render. */
+    void renderEnvelope (float* dest, int numSamples, int stride);
+
+    /** Returns the current envelope level, used to pick which voice to steal. */
+    float getEnvelopeLevel() const noexcept { return adsr.getCurrentValue(); }
+
+    /** Returns true once the voice's note has been released and its envelope is fading out. */
+    bool isReleasing() const noexcept { return adsr.isReleasing(); }
+
+    // Short enough that a stolen note starts without a noticeable delay, long enough not to click
+    static constexpr double fadeOutSeconds = 0.003;
+
+private:
+    ADSR adsr;
 
-    juce::dsp::Gain<float> gain;
+    // Linear fade applied on top of the envelope after fadeOut()
+    int fadeOutSamples = 1;
+    int fadeSamplesLeft = 0;
+    float fadeGain = 1.0f;
+    float fadeStep = 1.0f;
 
-    // Atomic param ptrs passed from PluginProcessor
-    std::atomic<float>* gainAtomic;
-    std::atomic<float>* oscAtomic;
-};
\ No newline at end of file
+    int currentNote = -1;
+    int currentChannel = 0;
+};
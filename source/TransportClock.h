@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+//==============================================================================
+/**
+Converts the host's PPQ position into integer ticks so tempo-synced step
+boundaries can be found exactly, however far into the song the playhead is.
+
+Call update() once per block with the host position, then forEachStep() for
+each step length to visit every step that starts inside the block. Odd steps
+can be delayed by a swing amount. The per-block path only uses integer math
+plus one multiply/divide to map ticks back to sample offsets.
+*/
+class TransportClock
+{
+public:
+    // Divisible by 3 (triplets) and by 32 (1/128 notes), and fine enough
+    // that one tick is well below one sample at any realistic tempo
+    static constexpr int64_t ticksPerQuarter = 960 * 4096;
+
+    /** Returns the length in ticks of a noteDurSync choice (0 = 1/128 note ... 6 = 1/2 note). */
+    static int64_t getStepTicks (int noteDurSyncIndex) noexcept
+    {
+        return (ticksPerQuarter * 4) >> (7 - noteDurSyncIndex);
+    }
+
+    /** Maps the block onto the tick timeline. */
+    void update (double ppqPosition, double bpm, double sampleRate, int numSamples) noexcept
+    {
+        samplesPerTick = 60.0 * sampleRate / (bpm * static_cast<double> (ticksPerQuarter));
+
+        auto startTick = std::llround (ppqPosition * static_cast<double> (ticksPerQuarter));
+        auto ticksPerSample = static_cast<int64_t> (1.0 / samplesPerTick) + 1;
+
+        // If the host continued from where the last block ended (give or take rounding),
+        // start exactly there so a step on the boundary is neither lost nor played twice
+        if (std::abs (startTick - blockEndTick) <= ticksPerSample)
+            startTick = blockEndTick;
+
+        blockStartTick = startTick;
+        blockEndTick = startTick + std::llround (numSamples / samplesPerTick);
+        blockSamples = numSamples;
+    }
+
+    /** Calls fn (sampleOffset, stepIndex) for every step of stepTicks whose start falls inside the block.
+
+    stepIndex counts steps from the start of the song. Odd steps are delayed by
+    swing * stepTicks / 2, so a swing of 1 pushes them halfway to the next step.
+    */
+    template <typename Fn>
+    void forEachStep (int64_t stepTicks, float swing, Fn&& fn) const
+    {
+        auto swingTicks = static_cast<int64_t> (swing * 0.5f * static_cast<float> (stepTicks));
+
+        // The earliest step that can start inside the block is the one a full swing offset before it
+        for (auto step = ceilDiv (blockStartTick - swingTicks, stepTicks);; ++step)
+        {
+            auto stepStartTick = step * stepTicks + ((step & 1) != 0 ? swingTicks : 0);
+
+            if (stepStartTick >= blockEndTick)
+                break;
+
+            if (stepStartTick < blockStartTick)
+                continue;
+
+            auto offset = static_cast<int> (static_cast<double> (stepStartTick - blockStartTick) * samplesPerTick);
+            fn (offset < blockSamples ? offset : blockSamples - 1, step);
+        }
+    }
+
+    /** Returns the number of samples in one step of stepTicks at the current tempo. */
+    double getStepSamples (int64_t stepTicks) const noexcept { return static_cast<double> (stepTicks) * samplesPerTick; }
+
+private:
+    // Rounds towards positive infinity, also for negative positions (count-in before bar 1)
+    static int64_t ceilDiv (int64_t numerator, int64_t denominator) noexcept
+    {
+        auto quotient = numerator / denominator;
+        return quotient + ((numerator % denominator) > 0 ? 1 : 0);
+    }
+
+    double samplesPerTick = 0.0;
+    int64_t blockStartTick = 0;
+    int64_t blockEndTick = 0;
+    int blockSamples = 0;
+};
@@ -0,0 +1,122 @@
+#include "VoiceBank.h"
+
+void VoiceBank::renderGroup (int group, const float* envelopes, const float* crossfade, float* outLeft, float* outRight, int numSamples) noexcept
+{
+    if (crossfade != nullptr)
+        render<true, true> (group, envelopes, crossfade, outLeft, outRight, numSamples);
+    else
+        render<true, false> (group, envelopes, nullptr, outLeft, outRight, numSamples);
+}
+
+void VoiceBank::renderGroupMono (int group, const float* envelopes, const float* crossfade, float* out, int numSamples) noexcept
+{
+    if (crossfade != nullptr)
+        render<false, true> (group, envelopes, crossfade, out, nullptr, numSamples);
+    else
+        render<false, false> (group, envelopes, nullptr, out, nullptr, numSamples);
+}
+
+template <bool stereo, bool crossfading>
+void VoiceBank::render (int group, const float* envelopes, const float* crossfade, float* outLeft, float* outRight, int numSamples) noexcept
+{
+    constexpr auto tableSize = static_cast<float> (Wavetables::tableSize);
+
+    // Every mip level of the waveform hangs off one base pointer, so each lane only differs by an offset.
+    // All waveforms share the same layout, so the offsets work for the previous one too
+    const float* table = Wavetables::getInstance().getTable (waveform, 0);
+    const float* fadeFromTable = Wavetables::getInstance().getTable (fadeFromWaveform, 0);
+    const auto first = static_cast<size_t> (group * groupSize);
+
+    // Keep the group's state in locals for the whole block so it stays in registers
+    alignas (32) float groupPhase[groupSize];
+    alignas (32) float groupIncrement[groupSize];
+    alignas (32) float groupLeft[groupSize];
+    alignas (32) float groupRight[groupSize];
+    alignas (32) int groupOffset[groupSize];
+
+    for (int lane = 0; lane < groupSize; ++lane)
+    {
+        groupPhase[lane] = phase[first + (size_t) lane];
+        groupIncrement[lane] = phaseIncrement[first + (size_t) lane];
+        // A mono mix uses the unpanned level, constant-power gains don't sum back to it
+        groupLeft[lane] = stereo ? leftGain[first + (size_t) lane] : level[first + (size_t) lane];
+        groupRight[lane] = rightGain[first + (size_t) lane];
+        groupOffset[lane] = mipOffset[first + (size_t) lane];
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float* frame = envelopes + i * groupSize;
+        alignas (32) float lanes[groupSize];
+
+        for (int lane = 0; lane < groupSize; ++lane)
+        {
+            auto position = groupPhase[lane] * tableSize;
+            auto index = static_cast<int> (position);
+            auto fraction = position - static_cast<float> (index);
+
+            auto a = table[groupOffset[lane] + index];
+            auto b = table[groupOffset[lane] + index + 1];
+
+            auto sample = a + fraction * (b - a);
+
+            if constexpr (crossfading)
+            {
+                auto fromA = fadeFromTable[groupOffset[lane] + index];
+                auto fromB = fadeFromTable[groupOffset[lane] + index + 1];
+                auto fromSample = fromA + fraction * (fromB - fromA);
+
+                sample = fromSample + crossfade[i] * (sample - fromSample);
+            }
+
+            lanes[lane] = sample * frame[lane];
+
+            groupPhase[lane] += groupIncrement[lane];
+            groupPhase[lane] -= groupPhase[lane] >= 1.0f ? 1.0f : 0.0f;
+        }
+
+        // Each voice is mono until here, it's spread to its place in the stereo field as it's summed
+        float left = 0.0f;
+        float right = 0.0f;
+
+        for (int lane = 0; lane < groupSize; ++lane)
+        {
+            left += lanes[lane] * groupLeft[lane];
+
+            if constexpr (stereo)
+                right += lanes[lane] * groupRight[lane];
+        }
+
+        outLeft[i] += left;
+
+        if constexpr (stereo)
+            outRight[i] += right;
+    }
+
+    for (int lane = 0; lane < groupSize; ++lane)
+        phase[first + (size_t) lane] = groupPhase[lane];
+}
+
+void VoiceBank::renderVoice (int slot, float* dest, int numSamples) noexcept
+{
+    constexpr auto tableSize = static_cast<float> (Wavetables::tableSize);
+
+    const float* table = Wavetables::getInstance().getTable (waveform, 0) + mipOffset[(size_t) slot];
+    auto voicePhase = phase[(size_t) slot];
+    auto increment = phaseIncrement[(size_t) slot];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto position = voicePhase * tableSize;
+        auto index = static_cast<int> (position);
+        auto fraction = position - static_cast<float> (index);
+
+        dest[i] = table[index] + fraction * (table[index + 1] - table[index]);
+
+        voicePhase += increment;
+        if (voicePhase >= 1.0f)
+            voicePhase -= 1.0f;
+    }
+
+    phase[(size_t) slot] = voicePhase;
+}
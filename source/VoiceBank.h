@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+
+#include "Wavetable.h"
+
+//==============================================================================
+/**
+Structure-of-arrays oscillator state for all synth voices.
+
+Voices are rendered in groups of groupSize: phase, phase increment, mip level
+and gains for each voice in a group sit next to each other, so one group is
+advanced by a single pass over the block whose per-voice (lane) loop the
+compiler unrolls and vectorizes. With groupSize = 8 a group fills one AVX
+register or two SSE/NEON registers.
+
+Each voice is rendered as one mono signal and only spread to the output
+channels as the group is summed.
+
+Voices are addressed by slot, the index of the SynthVoice in SynthEngine's
+voice array. Slot s belongs to group s / groupSize.
+*/
+class VoiceBank
+{
+public:
+    static constexpr int groupSize = 8;
+    static constexpr int maxVoices = 128;
+    static constexpr int maxGroups = maxVoices / groupSize;
+
+    // Constant-power pan law sampled across [-1, 1], compensated by +3 dB so the centre is unity
+    static constexpr int panTableSize = 129;
+
+    struct PanGains
+    {
+        float left, right;
+    };
+
+    /** Returns the constant-power gains for a pan from -1.0 (left) to 1.0 (right), read from a lookup table.
+
+    A centred note plays at unity on both channels, as it did before notes were
+    panned, and a hard-panned one at +3 dB on its side.
+    */
+    static PanGains getPanGains (float pan) noexcept
+    {
+        const auto& table = getPanTable();
+        auto index = static_cast<int> (std::lround ((pan + 1.0f) * 0.5f * (panTableSize - 1)));
+        index = index < 0 ? 0 : (index >= panTableSize ? panTableSize - 1 : index);
+
+        return { table[(size_t) (panTableSize - 1 - index)], table[(size_t) index] };
+    }
+
+    void prepare (double newSampleRate)
+    {
+        // Make sure the shared tables are built here rather than on the audio thread
+        Wavetables::getInstance();
+        getPanTable();
+
+        sampleRate = newSampleRate;
+        phase.fill (0.0f);
+    }
+
+    /** Sets the waveform used by every voice (the "osc" parameter).
+
+    The previous waveform is kept so a render can crossfade from it to the new one.
+    */
+    void setWaveform (int newWaveform) noexcept
+    {
+        fadeFromWaveform = waveform;
+        waveform = newWaveform;
+    }
+
+    /** Sets the waveform with nothing to crossfade from. */
+    void resetWaveform (int newWaveform) noexcept { waveform = fadeFromWaveform = newWaveform; }
+
+    /** Sets up a slot for a new note, the mip level is picked for its pitch and its pan gains are looked up once. */
+    void startVoice (int slot, double frequency, float velocity, float pan) noexcept
+    {
+        auto gains = getPanGains (pan);
+
+        phaseIncrement[(size_t) slot] = static_cast<float> (frequency / sampleRate);
+        mipOffset[(size_t) slot] = Wavetables::getMipLevel (phaseIncrement[(size_t) slot]) * Wavetables::mipLevelStride;
+        level[(size_t) slot] = velocity;
+        leftGain[(size_t) slot] = velocity * gains.left;
+        rightGain[(size_t) slot] = velocity * gains.right;
+    }
+
+    /** Renders every voice in a group, panned, and adds their sum to outLeft and outRight.
+
+    envelopes holds numSamples frames of groupSize envelope values, interleaved
+    so frame n of the voice in lane l is envelopes[n * groupSize + l]. Lanes of
+    voices that aren't playing must have an envelope of 0.
+
+    If crossfade isn't nullptr, sample n reads both waveforms and mixes in the
+    current one by crossfade[n] (0 = all previous waveform, 1 = all current).
+    */
+    void renderGroup (int group, const float* envelopes, const float* crossfade, float* outLeft, float* outRight, int numSamples) noexcept;
+
+    /** Like renderGroup(), but sums the voices unpanned into a single channel for a mono bus. */
+    void renderGroupMono (int group, const float* envelopes, const float* crossfade, float* out, int numSamples) noexcept;
+
+    /** Writes numSamples of a single voice's oscillator to dest (without gain or envelope). */
+    void renderVoice (int slot, float* dest, int numSamples) noexcept;
+
+private:
+    template <bool stereo, bool crossfading>
+    void render (int group, const float* envelopes, const float* crossfade, float* outLeft, float* outRight, int numSamples) noexcept;
+
+    static const std::array<float, panTableSize>& getPanTable()
+    {
+        // Quarter sine scaled by sqrt (2), entry i is the right gain at pan index i (and the left gain at the mirrored index)
+        static const auto table = [] {
+            std::array<float, panTableSize> quarterSine {};
+
+            for (size_t i = 0; i < quarterSine.size(); ++i)
+                quarterSine[i] = static_cast<float> (1.4142135623730951 * std::sin (1.5707963267948966 * static_cast<double> (i) / (panTableSize - 1)));
+
+            return quarterSine;
+        }();
+
+        return table;
+    }
+
+    double sampleRate = 44100.0;
+    int waveform = Wavetables::sine;
+    int fadeFromWaveform = Wavetables::sine;
+
+    alignas (32) std::array<float, maxVoices> phase {}; // in cycles, [0, 1)
+    alignas (32) std::array<float, maxVoices> phaseIncrement {}; // cycles per sample
+    alignas (32) std::array<float, maxVoices> level {}; // velocity
+    alignas (32) std::array<float, maxVoices> leftGain {}; // velocity * pan gain
+    alignas (32) std::array<float, maxVoices> rightGain {};
+    alignas (32) std::array<int, maxVoices> mipOffset {}; // mip level * Wavetables::mipLevelStride
+};
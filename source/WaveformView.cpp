@@ -0,0 +1,89 @@
+#include "WaveformView.h"
+
+WaveformView::WaveformView (PeakBuffer& peakBuffer)
+    : peaks (peakBuffer)
+{
+    setOpaque (true);
+}
+
+WaveformView::~WaveformView()
+{
+    peaks.setActive (false);
+}
+
+void WaveformView::setColours (juce::Colour newBackgroundColour, juce::Colour newWaveformColour)
+{
+    backgroundColour = newBackgroundColour;
+    waveformColour = newWaveformColour;
+    repaint();
+}
+
+//==============================================================================
+void WaveformView::paint (juce::Graphics& g)
+{
+    g.fillAll (backgroundColour);
+    g.setColour (waveformColour);
+
+    auto bounds = getLocalBounds().toFloat();
+    const float channelHeight = bounds.getHeight() / PeakBuffer::numChannels;
+    const float columnWidth = bounds.getWidth() / historySize;
+
+    // Each channel gets its own lane, one filled min/max column per peak, oldest on the left
+    for (int ch = 0; ch < PeakBuffer::numChannels; ++ch)
+    {
+        const float centre = bounds.getY() + channelHeight * (ch + 0.5f);
+        const float scale = channelHeight * 0.5f;
+
+        juce::Path path;
+
+        for (int i = 0; i < historySize; ++i)
+        {
+            const auto& peak = history[(size_t) ((historyEnd + i) % historySize)];
+            const float top = centre - juce::jlimit (-1.0f, 1.0f, peak.max[(size_t) ch]) * scale;
+            const float bottom = centre - juce::jlimit (-1.0f, 1.0f, peak.min[(size_t) ch]) * scale;
+
+            path.addRectangle (bounds.getX() + i * columnWidth, top, columnWidth, juce::jmax (1.0f, bottom - top));
+        }
+
+        g.fillPath (path);
+    }
+}
+
+void WaveformView::visibilityChanged()
+{
+    updateFeed();
+}
+
+void WaveformView::parentHierarchyChanged()
+{
+    updateFeed();
+}
+
+//==============================================================================
+void WaveformView::timerCallback()
+{
+    auto num = peaks.read (incoming.data(), historySize);
+
+    if (num == 0)
+        return;
+
+    for (int i = 0; i < num; ++i)
+    {
+        history[(size_t) historyEnd] = incoming[(size_t) i];
+        historyEnd = (historyEnd + 1) % historySize;
+    }
+
+    repaint();
+}
+
+void WaveformView::updateFeed()
+{
+    const bool showing = isShowing();
+
+    peaks.setActive (showing);
+
+    if (showing && ! isTimerRunning())
+        startTimerHz (refreshRateHz);
+    else if (! showing)
+        stopTimer();
+}
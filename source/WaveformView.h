@@ -0,0 +1,43 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "PeakBuffer.h"
+
+//==============================================================================
+/**
+Scrolling min/max display of the plugin's output, fed by a PeakBuffer.
+
+A timer pulls the newest peaks on the message thread and repaints. The timer
+runs, and the feed is switched on, only while the view is showing.
+*/
+class WaveformView : public juce::Component, private juce::Timer
+{
+public:
+    explicit WaveformView (PeakBuffer& peakBuffer);
+    ~WaveformView() override;
+
+    void setColours (juce::Colour newBackgroundColour, juce::Colour newWaveformColour);
+
+    //==============================================================================
+    void paint (juce::Graphics& g) override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+
+private:
+    void timerCallback() override;
+    void updateFeed();
+
+    // Number of peaks shown across the width of the view
+    static constexpr int historySize = 512;
+    static constexpr int refreshRateHz = 30;
+
+    PeakBuffer& peaks;
+
+    std::array<PeakBuffer::Peak, historySize> history {};
+    std::array<PeakBuffer::Peak, historySize> incoming {};
+    int historyEnd = 0; // index after the newest peak, history is a ring
+
+    juce::Colour backgroundColour { juce::Colours::black };
+    juce::Colour waveformColour { juce::Colours::white };
+};
@@ -0,0 +1,64 @@
+#include "Wavetable.h"
+
+Wavetables::Wavetables()
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    // sin (2 pi k n / tableSize) is sineTable[(k * n) % tableSize], so the additive
+    // synthesis below needs no trig calls past this one table
+    std::vector<double> sineTable (tableSize);
+
+    for (int n = 0; n < tableSize; ++n)
+        sineTable[(size_t) n] = std::sin (2.0 * pi * n / tableSize);
+
+    // Fourier series of the waveforms the oscillators used to compute directly
+    auto harmonicAmplitude = [pi] (int waveform, int k) -> double {
+        switch (waveform)
+        {
+            case sine:
+                return k == 1 ? 1.0 : 0.0;
+
+            case triangle: // 2 / pi * asin (sin (x))
+                return k % 2 == 0 ? 0.0 : 8.0 / (pi * pi * k * k) * (k % 4 == 1 ? 1.0 : -1.0);
+
+            case sawtooth: // x / pi for x in [-pi, pi)
+                return 2.0 / (pi * k) * (k % 2 == 1 ? 1.0 : -1.0);
+
+            case square: // -1 for x < 0, 1 otherwise
+                return k % 2 == 0 ? 0.0 : 4.0 / (pi * k);
+
+            default:
+                return 0.0;
+        }
+    };
+
+    std::vector<double> sum (tableSize);
+
+    for (int waveform = 0; waveform < numWaveforms; ++waveform)
+    {
+        for (int level = 0; level < numMipLevels; ++level)
+        {
+            std::fill (sum.begin(), sum.end(), 0.0);
+
+            int maxHarmonic = std::max (1, (tableSize / 2 - 1) >> level);
+
+            for (int k = 1; k <= maxHarmonic; ++k)
+            {
+                auto amplitude = harmonicAmplitude (waveform, k);
+
+                if (amplitude == 0.0)
+                    continue;
+
+                for (int n = 0; n < tableSize; ++n)
+                    sum[(size_t) n] += amplitude * sineTable[(size_t) ((k * n) % tableSize)];
+            }
+
+            auto& table = tables[(size_t) waveform][(size_t) level];
+
+            for (int n = 0; n < tableSize; ++n)
+                table[(size_t) n] = static_cast<float> (sum[(size_t) n]);
+
+            table[tableSize] = table[0];
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+/**
+Shared, read-only band-limited wavetables for the oscillator waveforms.
+
+Each waveform is stored as a set of mip levels, one per octave: level 0
+holds every harmonic a tableSize table can represent and each level above
+holds half as many. The tables are built once, additively, the first time
+getInstance() is called (do that off the audio thread, e.g. in prepareToPlay).
+*/
+class Wavetables
+{
+public:
+    enum Waveform
+    {
+        sine,
+        triangle,
+        sawtooth,
+        square,
+        numWaveforms
+    };
+
+    static constexpr int tableSize = 2048;
+    static constexpr int numMipLevels = 11; // tableSize / 2 harmonics at level 0 down to 1 at the top
+
+    /** Returns the shared tables, building them on first use. */
+    static const Wavetables& getInstance()
+    {
+        static const Wavetables instance;
+        return instance;
+    }
+
+    /** Returns the mip level whose harmonics all stay below Nyquist for a phase increment (in cycles per sample). */
+    static int getMipLevel (float phaseIncrement) noexcept
+    {
+        // Level m holds harmonics up to (tableSize / 2) >> m, which must not exceed 0.5 / phaseIncrement
+        int level = 0;
+
+        for (float maxHarmonic = tableSize / 2; level < numMipLevels - 1 && maxHarmonic * phaseIncrement > 0.5f; maxHarmonic *= 0.5f)
+            ++level;
+
+        return level;
+    }
+
+    /** Returns a table of tableSize + 1 samples, the last one repeating the first so interpolation never wraps. */
+    const float* getTable (int waveform, int mipLevel) const noexcept
+    {
+        return tables[(size_t) waveform][(size_t) mipLevel].data();
+    }
+
+    // Distance between the starts of two consecutive mip levels of a waveform,
+    // so getTable (w, m) == getTable (w, 0) + m * mipLevelStride
+    static constexpr int mipLevelStride = tableSize + 1;
+
+private:
+    Wavetables();
+
+    using Table = std::array<float, tableSize + 1>;
+    std::array<std::array<Table, numMipLevels>, numWaveforms> tables;
+};
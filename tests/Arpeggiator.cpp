@@ -0,0 +1,314 @@
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    struct ArpHarness
+    {
+        explicit ArpHarness (float noteDurSeconds)
+        {
+            // Only the first lane plays unless a test switches the others on
+            for (auto& lane : params.lanes)
+            {
+                lane.enabled = &lane == &params.lanes[0];
+                lane.noteDurSamples = static_cast<int> (noteDurSeconds * sampleRate);
+                lane.stepTicks = TransportClock::getStepTicks (5);
+            }
+
+            arp.prepareToPlay (sampleRate, maxBlockSize);
+        }
+
+        // Renders totalSamples in blocks of blockSize while holding the given notes,
+        // returning the absolute sample position and note number of every note-on the arp emitted
+        std::vector<std::pair<int, int>> run (int totalSamples, int blockSize, std::initializer_list<int> heldNotes, int channel = 1)
+        {
+            std::vector<std::pair<int, int>> noteOns;
+            ArpEventList events;
+            juce::Optional<juce::AudioPlayHead::PositionInfo> noPosition;
+
+            for (int pos = 0; pos < totalSamples; pos += blockSize)
+            {
+                juce::MidiBuffer midi;
+
+                if (pos == 0)
+                    for (auto note : heldNotes)
+                        midi.addEvent (juce::MidiMessage::noteOn (1, note, (juce::uint8) 100), 0);
+
+                arp.processBlock (blockSize, midi, noPosition, params, events);
+
+                for (const auto& event : events)
+                    if (event.isNoteOn() && event.channel == channel)
+                        noteOns.emplace_back (pos + event.offset, event.note);
+            }
+
+            return noteOns;
+        }
+
+        static constexpr double sampleRate = 48000.0;
+        static constexpr int maxBlockSize = 4096;
+
+        ParameterSnapshot params;
+        Arpeggiator arp;
+    };
+}
+
+TEST_CASE ("Arpeggiator emits every step regardless of block size", "[arpeggiator]")
+{
+    // 1 ms steps (48 samples) are much shorter than a typical host block
+    const int totalSamples = 49152;
+
+    auto smallBlocks = ArpHarness (0.001f).run (totalSamples, 32, { 60, 64, 67 });
+    auto largeBlocks = ArpHarness (0.001f).run (totalSamples, 2048, { 60, 64, 67 });
+
+    CHECK (smallBlocks.size() == 1023);
+    CHECK (smallBlocks == largeBlocks);
+}
+
+TEST_CASE ("Arpeggiator random decisions are reproducible from the seed", "[arpeggiator]")
+{
+    auto render = [] (juce::uint32 seed, int blockSize) {
+        ArpHarness harness (0.002f);
+        harness.params.lanes[0].randomize = 0.5f;
+        harness.params.lanes[0].density = 0.5f;
+        harness.arp.setSeed (seed);
+        return harness.run (49152, blockSize, { 60, 63, 67, 70 });
+    };
+
+    auto reference = render (1234, 64);
+
+    CHECK (render (1234, 64) == reference);
+    CHECK (render (1234, 4096) == reference);
+    CHECK (render (4321, 64) != reference);
+}
+
+TEST_CASE ("Arpeggiator random steps come from the lane's step table", "[arpeggiator]")
+{
+    ArpHarness harness (0.001f);
+    harness.params.lanes[0].randomize = 1.0f;
+    harness.params.numOctaves = 2;
+
+    auto noteOns = harness.run (48000, 512, { 60, 64 });
+    bool allFromTable = true;
+    bool upperOctave = false;
+
+    for (auto [position, note] : noteOns)
+    {
+        allFromTable = allFromTable && (note == 60 || note == 64 || note == 72 || note == 76);
+        upperOctave = upperOctave || note >= 72;
+    }
+
+    REQUIRE_FALSE (noteOns.empty());
+    CHECK (allFromTable);
+    CHECK (upperOctave);
+}
+
+TEST_CASE ("Arpeggiator lanes run independently on their own channels", "[arpeggiator]")
+{
+    auto expected = ArpHarness (0.001f).run (4800, 512, { 60, 64 }, 1);
+
+    ArpHarness firstLane (0.001f);
+    firstLane.params.lanes[1].enabled = true;
+    CHECK (firstLane.run (4800, 512, { 60, 64 }, 1) == expected);
+
+    ArpHarness secondLane (0.001f);
+    secondLane.params.lanes[1].enabled = true;
+    CHECK (secondLane.run (4800, 512, { 60, 64 }, 2) == expected);
+}
+
+TEST_CASE ("Arpeggiator ends every note it starts in long blocks of fast steps", "[arpeggiator]")
+{
+    const double sampleRate = 48000.0;
+    const int blockSize = 4096;
+    const std::vector<int> chord { 48, 50, 52, 53, 55, 57, 59, 60, 62, 64 };
+
+    struct Setup
+    {
+        ArpPattern::Mode pattern;
+        int capacity;
+    };
+
+    // One note per step and whole chords, in a list sized for the block as the processor prepares it,
+    // and chords in the smaller default list
+    const Setup setups[] = {
+        { ArpPattern::Mode::up, Arpeggiator::getMaxEventsPerBlock (sampleRate, blockSize) },
+        { ArpPattern::Mode::chord, Arpeggiator::getMaxEventsPerBlock (sampleRate, blockSize) },
+        { ArpPattern::Mode::chord, ArpEventList::defaultCapacity },
+    };
+
+    for (const auto& [pattern, capacity] : setups)
+    {
+        ParameterSnapshot params;
+
+        for (auto& lane : params.lanes)
+        {
+            lane.noteDurSamples = static_cast<int> (Arpeggiator::minNoteDuration * sampleRate);
+            lane.pattern = pattern;
+        }
+
+        Arpeggiator arp;
+        arp.prepareToPlay (sampleRate, blockSize);
+
+        ArpEventList events;
+        events.prepare (capacity);
+
+        juce::Optional<juce::AudioPlayHead::PositionInfo> noPosition;
+        std::array<std::array<int, 128>, 16> sounding {};
+        int numNoteOns = 0;
+        bool unmatchedNoteOff = false;
+
+        for (int block = 0; block < 8; ++block)
+        {
+            // Hold the chord for six blocks, then let go
+            juce::MidiBuffer midi;
+
+            for (auto note : chord)
+            {
+                if (block == 0)
+                    midi.addEvent (juce::MidiMessage::noteOn (1, note, (juce::uint8) 100), 0);
+                else if (block == 6)
+                    midi.addEvent (juce::MidiMessage::noteOff (1, note), 0);
+            }
+
+            arp.processBlock (blockSize, midi, noPosition, params, events);
+
+            for (const auto& event : events)
+            {
+                auto& count = sounding[(size_t) event.channel - 1][event.note];
+
+                if (event.isNoteOn())
+                {
+                    ++count;
+                    ++numNoteOns;
+                }
+                else
+                {
+                    unmatchedNoteOff = unmatchedNoteOff || count == 0;
+                    count = 0;
+                }
+            }
+        }
+
+        CHECK_FALSE (unmatchedNoteOff);
+
+        for (const auto& channel : sounding)
+            for (auto count : channel)
+                CHECK (count == 0);
+
+        // One note per step fits, so every step of every lane plays. Chords this fast only fit
+        // in part, the steps past a lane's room are dropped. The first step comes one note in
+        // and the one at the release finds nothing held.
+        const int numSteps = 6 * blockSize / params.lanes[0].noteDurSamples - 1;
+
+        if (pattern == ArpPattern::Mode::up)
+            CHECK (numNoteOns == Arpeggiator::maxLanes * numSteps);
+        else
+            CHECK (numNoteOns < Arpeggiator::maxLanes * numSteps * static_cast<int> (chord.size()));
+
+        CHECK (numNoteOns > 0);
+    }
+}
+
+TEST_CASE ("ArpEventList keeps events sorted by offset", "[arpeggiator]")
+{
+    // Two lanes' lists merged, as the arp does
+    std::array<ArpEventList, 2> lanes;
+    lanes[0].add ({ 10, ArpEvent::Type::noteOff, 1, 60 });
+    lanes[0].add ({ 10, ArpEvent::Type::noteOn, 1, 64 });
+    lanes[0].add ({ 40, ArpEvent::Type::noteOn, 1, 67 });
+    lanes[1].add ({ 5, ArpEvent::Type::noteOn, 2, 72 });
+    lanes[1].add ({ 10, ArpEvent::Type::noteOn, 2, 76 });
+
+    ArpEventList events;
+    events.merge (lanes.data(), (int) lanes.size());
+
+    REQUIRE (events.size() == 5);
+    CHECK (events[0].note == 72);
+    CHECK (events[1].note == 60);
+    CHECK (events[2].note == 64);
+    CHECK (events[3].note == 76);
+    CHECK (events[4].note == 67);
+}
+
+TEST_CASE ("TransportClock finds every synced step far into a song", "[arpeggiator]")
+{
+    const double sampleRate = 44100.0;
+    const double bpm = 137.0;
+    const int blockSize = 511;
+    const auto stepTicks = TransportClock::getStepTicks (3); // 1/16 note
+
+    for (double startPpq : { 0.0, 1.0e6 })
+    {
+        TransportClock clock;
+        double ppq = startPpq;
+        int64_t expectedStep = -1;
+        bool contiguous = true;
+
+        for (int block = 0; block < 2000; ++block)
+        {
+            clock.update (ppq, bpm, sampleRate, blockSize);
+            clock.forEachStep (stepTicks, 0.5f, [&] (int, int64_t step) {
+                contiguous = contiguous && (expectedStep < 0 || step == expectedStep);
+                expectedStep = step + 1;
+            });
+
+            ppq += blockSize * bpm / (60.0 * sampleRate);
+        }
+
+        CHECK (contiguous);
+        CHECK (expectedStep - static_cast<int64_t> (startPpq * 4) == 212);
+    }
+}
+
+TEST_CASE ("HeldNotes indexes notes in ascending order", "[arpeggiator]")
+{
+    HeldNotes notes;
+
+    for (auto note : { 67, 0, 127, 60, 64, 60 })
+        notes.add (note);
+
+    REQUIRE (notes.size() == 5);
+    CHECK (notes[0] == 0);
+    CHECK (notes[1] == 60);
+    CHECK (notes[2] == 64);
+    CHECK (notes[3] == 67);
+    CHECK (notes[4] == 127);
+    CHECK (notes[5] == -1);
+
+    notes.removeValue (64);
+    notes.removeValue (12);
+
+    CHECK (notes.size() == 4);
+    CHECK (notes[2] == 67);
+    CHECK_FALSE (notes.contains (64));
+}
+
+TEST_CASE ("ArpPattern compiles playback orders into a step table", "[arpeggiator]")
+{
+    HeldNotes notes;
+
+    for (auto note : { 64, 60, 67 })
+        notes.add (note);
+
+    auto stepNotes = [&] (ArpPattern::Mode mode, int numOctaves) {
+        ArpPattern pattern;
+        pattern.compile (notes, mode, numOctaves);
+
+        std::vector<int> result;
+        for (int i = 0; i < pattern.getNumSteps(); ++i)
+            for (auto note : pattern.getStep (i))
+                result.push_back (note);
+        return result;
+    };
+
+    CHECK (stepNotes (ArpPattern::Mode::up, 1) == std::vector<int> { 60, 64, 67 });
+    CHECK (stepNotes (ArpPattern::Mode::down, 1) == std::vector<int> { 67, 64, 60 });
+    CHECK (stepNotes (ArpPattern::Mode::upDown, 1) == std::vector<int> { 60, 64, 67, 64 });
+    CHECK (stepNotes (ArpPattern::Mode::converge, 1) == std::vector<int> { 60, 67, 64 });
+    CHECK (stepNotes (ArpPattern::Mode::asPlayed, 1) == std::vector<int> { 64, 60, 67 });
+    CHECK (stepNotes (ArpPattern::Mode::up, 2) == std::vector<int> { 60, 64, 67, 72, 76, 79 });
+
+    ArpPattern chord;
+    chord.compile (notes, ArpPattern::Mode::chord, 1);
+    CHECK (chord.getNumSteps() == 1);
+    CHECK (chord.getStep (0).size() == 3);
+}
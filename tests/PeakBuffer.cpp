@@ -0,0 +1,55 @@
+#include <PeakBuffer.h>
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE ("PeakBuffer only collects peaks while active", "[visualiser]")
+{
+    PeakBuffer peaks;
+    std::vector<PeakBuffer::Peak> read (PeakBuffer::capacity);
+
+    juce::AudioBuffer<float> buffer (2, 512);
+    buffer.clear();
+
+    peaks.push (buffer);
+    CHECK (peaks.read (read.data(), (int) read.size()) == 0);
+
+    peaks.setActive (true);
+    peaks.push (buffer);
+    CHECK (peaks.read (read.data(), (int) read.size()) == 512 / PeakBuffer::samplesPerPeak);
+    CHECK (peaks.read (read.data(), (int) read.size()) == 0);
+}
+
+TEST_CASE ("PeakBuffer reduces each channel to its min and max across blocks", "[visualiser]")
+{
+    PeakBuffer peaks;
+    peaks.setActive (true);
+
+    // Blocks that don't line up with the peak size, the first peak spans two of them
+    juce::AudioBuffer<float> buffer (1, 100);
+    buffer.clear();
+    buffer.setSample (0, 10, 0.5f);
+    peaks.push (buffer);
+
+    buffer.clear();
+    buffer.setSample (0, 20, -0.25f);
+    peaks.push (buffer);
+
+    std::vector<PeakBuffer::Peak> read (4);
+    REQUIRE (peaks.read (read.data(), 4) == 1);
+
+    // A mono buffer feeds both channels
+    for (size_t ch = 0; ch < PeakBuffer::numChannels; ++ch)
+    {
+        CHECK (read[0].max[ch] == 0.5f);
+        CHECK (read[0].min[ch] == -0.25f);
+    }
+
+    // Only the newest peaks are kept when the reader asks for fewer than arrived
+    juce::AudioBuffer<float> longBuffer (2, PeakBuffer::samplesPerPeak * 10);
+    longBuffer.clear();
+    longBuffer.setSample (1, longBuffer.getNumSamples() - PeakBuffer::samplesPerPeak, 1.0f);
+    peaks.push (longBuffer);
+
+    REQUIRE (peaks.read (read.data(), 4) == 4);
+    CHECK (read[3].max[1] == 1.0f);
+    CHECK (read[3].max[0] == 0.0f);
+}
@@ -8,6 +8,35 @@ TEST_CASE ("one is equal to one", "[dummy]")
     REQUIRE (1 == 1);
 }
 
+TEST_CASE ("Plugin restores the arp direction of states saved with the ascending toggle", "[instance]")
+{
+    for (bool ascending : { false, true })
+    {
+        // A state from before the pattern choice: an "ascending" parameter and no "pattern"
+        PluginProcessor saved;
+        auto xml = saved.getState().copyState().createXml();
+        xml->removeChildElement (xml->getChildByAttribute ("id", "pattern"), true);
+
+        auto* legacy = xml->createNewChildElement ("PARAM");
+        legacy->setAttribute ("id", "ascending");
+        legacy->setAttribute ("value", ascending ? 1.0 : 0.0);
+
+        juce::MemoryBlock data;
+        juce::AudioProcessor::copyXmlToBinary (*xml, data);
+
+        // Start from another pattern, so the restored one can only come from the migration
+        PluginProcessor restored;
+        auto* pattern = restored.getState().getParameter ("pattern");
+        pattern->setValueNotifyingHost (pattern->convertTo0to1 (static_cast<float> (static_cast<int> (ArpPattern::Mode::chord))));
+
+        restored.setStateInformation (data.getData(), static_cast<int> (data.getSize()));
+
+        auto expected = ascending ? ArpPattern::Mode::up : ArpPattern::Mode::down;
+        CHECK (static_cast<int> (restored.getState().getRawParameterValue ("pattern")->load()) == static_cast<int> (expected));
+        CHECK_FALSE (restored.getState().state.getChildWithProperty ("id", "ascending").isValid());
+    }
+}
+
 //TEST_CASE ("Plugin instance", "[instance]")
 //{
 //    PluginProcessor testPlugin;
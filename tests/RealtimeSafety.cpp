@@ -0,0 +1,204 @@
+#include "helpers/RealtimeChecker.h"
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    /** A transport the workload starts, stops and changes the tempo of. */
+    class StressPlayHead : public juce::AudioPlayHead
+    {
+    public:
+        juce::Optional<PositionInfo> getPosition() const override
+        {
+            PositionInfo info;
+            info.setBpm (bpm);
+            info.setTimeInSamples (position);
+            info.setPpqPosition (static_cast<double> (position) / sampleRate * bpm / 60.0);
+            info.setIsPlaying (playing);
+            return info;
+        }
+
+        double sampleRate = 48000.0;
+        double bpm = 120.0;
+        juce::int64 position = 0;
+        bool playing = true;
+    };
+
+    void setParameter (PluginProcessor& plugin, const juce::String& paramID, float value)
+    {
+        auto* param = plugin.getState().getParameter (paramID);
+        param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    /** Sets a parameter to a random value in its range. */
+    void setRandomParameter (PluginProcessor& plugin, const juce::String& paramID, juce::Random& random)
+    {
+        plugin.getState().getParameter (paramID)->setValueNotifyingHost (random.nextFloat());
+    }
+
+    /** Fails the test with the stack trace of every violation recorded since the last call. */
+    void requireNoViolations()
+    {
+        const auto violations = RealtimeChecker::takeViolations();
+
+        for (const auto& violation : violations)
+            UNSCOPED_INFO ("processBlock called " << violation.what << "\n" << violation.stackTrace);
+
+        REQUIRE (violations.empty());
+    }
+}
+
+TEST_CASE ("RealtimeChecker reports allocations and locks inside a real-time section", "[realtime]")
+{
+    RealtimeChecker::takeViolations();
+
+    auto allocateAndLock = [] {
+        juce::MemoryBlock block (1024);
+
+        juce::CriticalSection lock;
+        const juce::ScopedLock sl (lock);
+    };
+
+    // Outside a section nothing is reported
+    allocateAndLock();
+    CHECK (RealtimeChecker::takeViolations().empty());
+
+    {
+        const RealtimeCheck::ScopedRealtimeSection section;
+        allocateAndLock();
+    }
+
+    auto violations = RealtimeChecker::takeViolations();
+
+    auto contains = [&] (const juce::String& what) {
+        return std::any_of (violations.begin(), violations.end(), [&] (const auto& v) { return v.what == what && v.stackTrace.isNotEmpty(); });
+    };
+
+    if (RealtimeChecker::canDetectMalloc())
+    {
+        CHECK (contains ("malloc"));
+        CHECK (contains ("free"));
+    }
+
+    if (RealtimeChecker::canDetectLocks())
+        CHECK (contains ("pthread_mutex_lock"));
+}
+
+TEST_CASE ("processBlock neither allocates nor locks under a stress MIDI workload", "[realtime]")
+{
+    if (! RealtimeChecker::canDetectMalloc())
+        SKIP ("Allocations can only be intercepted with glibc");
+
+    const double sampleRate = 48000.0;
+    const int maxBlockSize = 512;
+
+    PluginProcessor plugin;
+    StressPlayHead playHead;
+
+    // Four lanes stepping every two milliseconds, so most blocks hold many note changes
+    setParameter (plugin, "polyphony", static_cast<float> (SynthEngine::maxPolyphony));
+    setParameter (plugin, "release", 0.05f);
+
+    for (int lane = 0; lane < Arpeggiator::maxLanes; ++lane)
+    {
+        if (lane > 0)
+            setParameter (plugin, Arpeggiator::getLaneParamID ("laneOn", lane), 1.0f);
+
+        setParameter (plugin, Arpeggiator::getLaneParamID ("noteDur", lane), 0.002f);
+        setParameter (plugin, Arpeggiator::getLaneParamID ("noteDurSync", lane), 0.0f);
+    }
+
+    plugin.setPlayHead (&playHead);
+    plugin.setRateAndBufferSizeDetails (sampleRate, maxBlockSize);
+    plugin.prepareToPlay (sampleRate, maxBlockSize);
+
+    // Like a host's, the MIDI buffer only has room for the events put in it, so the arp's notes must fit without growing it
+    juce::AudioBuffer<float> buffer (2, maxBlockSize);
+    juce::MidiBuffer midi;
+
+    // The editor's side of the on-screen keyboard
+    auto& keyboard = plugin.getMidiKeyboardState();
+    plugin.getKeyboardBridge().setDisplayActive (true);
+
+    juce::Random random (1234);
+    std::array<bool, 128> held {};
+
+    RealtimeChecker::takeViolations();
+
+    // A minute of audio in blocks of random size
+    for (juce::int64 position = 0; position < static_cast<juce::int64> (60.0 * sampleRate);)
+    {
+        const int numSamples = random.nextInt ({ 1, maxBlockSize + 1 });
+
+        // About twice a second, change the sound and the patterns like a user tweaking the GUI
+        if (random.nextInt (50) == 0)
+        {
+            setRandomParameter (plugin, "osc", random);
+            setParameter (plugin, "sync", random.nextBool() ? 1.0f : 0.0f);
+            setParameter (plugin, "octaves", static_cast<float> (random.nextInt (2)));
+            setRandomParameter (plugin, "swing", random);
+            setRandomParameter (plugin, "width", random);
+            setParameter (plugin, "envLoop", random.nextBool() ? 1.0f : 0.0f);
+            setParameter (plugin, "midiOnly", random.nextInt (10) == 0 ? 1.0f : 0.0f);
+            setRandomParameter (plugin, "polyphony", random);
+
+            for (int lane = 0; lane < Arpeggiator::maxLanes; ++lane)
+            {
+                setRandomParameter (plugin, Arpeggiator::getLaneParamID ("pattern", lane), random);
+                setRandomParameter (plugin, Arpeggiator::getLaneParamID ("randomize", lane), random);
+                setRandomParameter (plugin, Arpeggiator::getLaneParamID ("density", lane), random);
+            }
+
+            playHead.playing = random.nextBool();
+            playHead.bpm = 60.0 + random.nextInt (240);
+        }
+
+        // Host notes at random offsets: mostly a few, now and then a large chord or everything off
+        const int numEvents = random.nextInt (20) == 0 ? 16 : random.nextInt (4);
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const int note = 36 + random.nextInt (16);
+            const int offset = random.nextInt (numSamples);
+
+            if (held[(size_t) note])
+                midi.addEvent (juce::MidiMessage::noteOff (1, note), offset);
+            else
+                midi.addEvent (juce::MidiMessage::noteOn (1, note, random.nextFloat()), offset);
+
+            held[(size_t) note] = ! held[(size_t) note];
+        }
+
+        if (random.nextInt (200) == 0)
+        {
+            for (int note = 0; note < 128; ++note)
+                if (std::exchange (held[(size_t) note], false))
+                    midi.addEvent (juce::MidiMessage::noteOff (1, note), numSamples - 1);
+        }
+
+        // Notes played on the on-screen keyboard
+        if (random.nextInt (10) == 0)
+        {
+            const int note = 60 + random.nextInt (12);
+
+            if (keyboard.isNoteOn (1, note))
+                keyboard.noteOff (1, note, 0.0f);
+            else
+                keyboard.noteOn (1, note, 0.8f);
+        }
+
+        juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), 2, numSamples);
+        plugin.processBlock (block, midi);
+
+        plugin.getKeyboardBridge().updateDisplay();
+        midi.clear();
+
+        playHead.position += numSamples;
+        position += numSamples;
+    }
+
+    plugin.getKeyboardBridge().setDisplayActive (false);
+    plugin.setPlayHead (nullptr);
+
+    requireNoViolations();
+}
@@ -0,0 +1,638 @@
+#include <PluginProcessor.h>
+#include <ADSR.h>
+#include <SynthEngine.h>
+#include <VoiceBank.h>
+#include <Wavetable.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    /** The ADSR as it was before the segment list: a recursive exponential per attack, decay and release stage. */
+    class ReferenceADSR
+    {
+    public:
+        ReferenceADSR (double sr, const ADSR::Parameters& p) : sampleRate (sr), parameters (p) {}
+
+        void noteOn()
+        {
+            sampleDelta = 0;
+
+            if (parameters.attack > 0.0f)
+                startStage (State::attack, parameters.attack * sampleRate, 0);
+            else if (parameters.decay > 0.0f)
+                startStage (State::decay, parameters.decay * sampleRate, 0);
+            else
+                startStage (State::sustain, 0.0, 0);
+        }
+
+        void noteOff()
+        {
+            if (state == State::idle)
+                return;
+
+            sampleDelta = 0;
+            releaseVal = envelopeVal;
+
+            if (parameters.release > 0.0f)
+                startStage (State::release, parameters.release * sampleRate, 0);
+            else
+                state = State::idle;
+        }
+
+        float getNextSample()
+        {
+            if (state == State::idle)
+                return 0.0f;
+
+            if (state == State::sustain)
+            {
+                envelopeVal = parameters.sustain;
+            }
+            else
+            {
+                envelopeVal = static_cast<float> (value);
+
+                if (sampleDelta > numSamples)
+                {
+                    sampleDelta = 0;
+
+                    if (state == State::attack && parameters.decay > 0.0f)
+                        startStage (State::decay, parameters.decay * sampleRate, 1);
+                    else if (state == State::release)
+                        state = State::idle;
+                    else
+                        startStage (State::sustain, 0.0, 0);
+                }
+                else
+                {
+                    value = value * multiplier + increment;
+                }
+            }
+
+            ++sampleDelta;
+            return envelopeVal;
+        }
+
+        bool isActive() const { return state != State::idle; }
+
+    private:
+        enum class State { idle, attack, decay, sustain, release };
+
+        void startStage (State newState, double length, int firstSample)
+        {
+            state = newState;
+            numSamples = length;
+
+            if (state == State::sustain)
+                return;
+
+            const double expo = parameters.expo;
+            const double range = std::exp (expo) - 1.0;
+            const bool ascending = state == State::attack;
+            const double scale = state == State::attack ? 1.0 : state == State::decay ? 1.0 - parameters.sustain : releaseVal;
+            const double offset = state == State::decay ? parameters.sustain : 0.0;
+
+            auto x = firstSample / numSamples;
+            multiplier = std::exp ((ascending ? expo : -expo) / numSamples);
+            value = scale * (ascending ? std::exp (expo * x) - 1.0 : std::exp (expo * (1.0 - x)) - 1.0) / range + offset;
+            increment = scale * (multiplier - 1.0) / range + offset * (1.0 - multiplier);
+        }
+
+        double sampleRate;
+        ADSR::Parameters parameters;
+
+        State state = State::idle;
+        float envelopeVal = 0.0f, releaseVal = 0.0f;
+        int sampleDelta = 0;
+        double numSamples = 0.0;
+        double value = 0.0, multiplier = 1.0, increment = 0.0;
+    };
+}
+
+TEST_CASE ("Wavetable mip levels keep every harmonic below Nyquist", "[synth]")
+{
+    for (double sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+    {
+        for (int note = 0; note < 128; ++note)
+        {
+            auto frequency = juce::MidiMessage::getMidiNoteInHertz (note);
+            auto level = Wavetables::getMipLevel (static_cast<float> (frequency / sampleRate));
+            auto highestHarmonic = juce::jmax (1, (Wavetables::tableSize / 2 - 1) >> level);
+
+            // The very top notes only have their fundamental left
+            if (highestHarmonic > 1)
+                CHECK (highestHarmonic * frequency < sampleRate / 2);
+        }
+    }
+}
+
+TEST_CASE ("Wavetable sawtooth matches the naive waveform away from the jump", "[synth]")
+{
+    const float* table = Wavetables::getInstance().getTable (Wavetables::sawtooth, 0);
+
+    // A quarter of the way through the cycle the naive x / pi saw is at 0.5
+    CHECK (std::abs (table[Wavetables::tableSize / 4] - 0.5f) < 0.01f);
+    CHECK (std::abs (table[Wavetables::tableSize * 3 / 4] + 0.5f) < 0.01f);
+}
+
+TEST_CASE ("VoiceBank group render matches rendering each voice on its own", "[synth]")
+{
+    const int numSamples = 300;
+    VoiceBank grouped, single;
+
+    for (auto* bank : { &grouped, &single })
+    {
+        bank->prepare (48000.0);
+        bank->setWaveform (Wavetables::sawtooth);
+
+        for (int slot = 0; slot < 2 * VoiceBank::groupSize; ++slot)
+            bank->startVoice (slot, 100.0 + 37.0 * slot, 0.5f, slot % 2 == 0 ? -0.5f : 0.25f);
+    }
+
+    // Ramping envelopes, one lane silent
+    std::vector<float> envelopes ((size_t) (numSamples * VoiceBank::groupSize));
+
+    for (int i = 0; i < numSamples; ++i)
+        for (int lane = 0; lane < VoiceBank::groupSize; ++lane)
+            envelopes[(size_t) (i * VoiceBank::groupSize + lane)] = lane == 3 ? 0.0f : 0.01f * (float) (i * (lane + 1)) / numSamples;
+
+    std::vector<float> left ((size_t) numSamples, 0.0f), right ((size_t) numSamples, 0.0f);
+    std::vector<float> expectedLeft ((size_t) numSamples, 0.0f), expectedRight ((size_t) numSamples, 0.0f), voice ((size_t) numSamples);
+    grouped.renderGroup (1, envelopes.data(), nullptr, left.data(), right.data(), numSamples);
+
+    for (int lane = 0; lane < VoiceBank::groupSize; ++lane)
+    {
+        auto gains = VoiceBank::getPanGains (lane % 2 == 0 ? -0.5f : 0.25f);
+        single.renderVoice (VoiceBank::groupSize + lane, voice.data(), numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto sample = voice[(size_t) i] * 0.5f * envelopes[(size_t) (i * VoiceBank::groupSize + lane)];
+            expectedLeft[(size_t) i] += sample * gains.left;
+            expectedRight[(size_t) i] += sample * gains.right;
+        }
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        CHECK (std::abs (left[(size_t) i] - expectedLeft[(size_t) i]) < 1e-6f);
+        CHECK (std::abs (right[(size_t) i] - expectedRight[(size_t) i]) < 1e-6f);
+    }
+}
+
+TEST_CASE ("SynthEngine plays arp events at their offsets", "[synth]")
+{
+    ParameterSnapshot params;
+    params.envelope = { 0.001f, 0.001f, 1.0f, 0.001f, 1.0f };
+    params.polyphony = SynthEngine::minPolyphony;
+
+    SynthEngine engine;
+    engine.prepareToPlay (48000.0, params);
+
+    // More notes than voices, the extra ones steal
+    ArpEventList events;
+
+    for (int note = 60; note < 60 + SynthEngine::minPolyphony + 2; ++note)
+        events.add ({ 100, ArpEvent::Type::noteOn, 1, static_cast<uint8_t> (note) });
+
+    for (int note = 60; note < 60 + SynthEngine::minPolyphony + 2; ++note)
+        events.add ({ 1000, ArpEvent::Type::noteOff, 1, static_cast<uint8_t> (note) });
+
+    juce::AudioBuffer<float> buffer (2, 4096);
+    buffer.clear();
+    engine.renderNextBlock (buffer, events, params);
+
+    // Silent before the first note-on, sounding while held, silent once the 1 ms release is over
+    CHECK (buffer.getMagnitude (0, 0, 100) == 0.0f);
+    CHECK (buffer.getMagnitude (0, 200, 800) > 0.0f);
+    CHECK (buffer.getMagnitude (0, 2000, 2096) == 0.0f);
+    CHECK (buffer.getMagnitude (1, 200, 800) == buffer.getMagnitude (0, 200, 800));
+}
+
+TEST_CASE ("SynthEngine adds overlapping voices to the output from their start sample", "[synth]")
+{
+    ParameterSnapshot params;
+    params.gain = 1.0f;
+    params.envelope = { 0.002f, 0.01f, 0.7f, 0.005f, 1.0f };
+
+    // Renders the given notes into a block that already holds other audio
+    auto render = [&] (std::initializer_list<std::pair<int, uint8_t>> notes) {
+        SynthEngine engine;
+        engine.prepareToPlay (48000.0, params);
+
+        ArpEventList events;
+
+        for (const auto& [offset, note] : notes)
+            events.add ({ offset, ArpEvent::Type::noteOn, 1, note, offset > 400 ? 0.5f : -0.5f });
+
+        juce::AudioBuffer<float> buffer (2, 2048);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::fill (buffer.getWritePointer (ch), 0.25f, buffer.getNumSamples());
+
+        engine.renderNextBlock (buffer, events, params);
+        return buffer;
+    };
+
+    // Two notes starting mid-block, the second while the first still sounds
+    auto both = render ({ { 300, 57 }, { 700, 64 } });
+    auto first = render ({ { 300, 57 } });
+    auto second = render ({ { 700, 64 } });
+
+    // Nothing is written before a voice's first sample, after it each voice's output adds to what is there
+    float maxError = 0.0f;
+    bool untouchedBeforeStart = true;
+
+    for (int ch = 0; ch < both.getNumChannels(); ++ch)
+    {
+        for (int i = 0; i < 300; ++i)
+            untouchedBeforeStart = untouchedBeforeStart && both.getSample (ch, i) == 0.25f;
+
+        for (int i = 0; i < both.getNumSamples(); ++i)
+            maxError = juce::jmax (maxError, std::abs (both.getSample (ch, i) - (first.getSample (ch, i) + second.getSample (ch, i) - 0.25f)));
+    }
+
+    CHECK (untouchedBeforeStart);
+    CHECK (first.getMagnitude (0, 300, 400) > 0.25f);
+    CHECK (maxError < 1e-5f);
+}
+
+TEST_CASE ("SynthEngine fades out stolen and trimmed voices without a step", "[synth]")
+{
+    ParameterSnapshot params;
+    params.gain = 1.0f;
+    params.envelope = { 0.005f, 0.001f, 1.0f, 0.005f, 1.0f };
+    params.polyphony = SynthEngine::minPolyphony;
+
+    // A 440 Hz sine moves by at most 2 pi 440 / 48000 = 0.058 per sample, a cut voice jumps much further
+    auto largestStep = [] (const juce::AudioBuffer<float>& buffer) {
+        float largest = 0.0f;
+
+        for (int i = 1; i < buffer.getNumSamples(); ++i)
+            largest = juce::jmax (largest, std::abs (buffer.getSample (0, i) - buffer.getSample (0, i - 1)));
+
+        return largest;
+    };
+
+    // Every voice but the first plays a filler note. Rendering the fillers on their own as
+    // well and subtracting them leaves only the voice under test.
+    auto addFillers = [] (ArpEventList& events) {
+        for (int i = 1; i < SynthEngine::minPolyphony; ++i)
+            events.add ({ 0, ArpEvent::Type::noteOn, 1, static_cast<uint8_t> (40 + i) });
+    };
+
+    auto render = [&] (SynthEngine& engine, const ArpEventList& events, int numSamples) {
+        juce::AudioBuffer<float> buffer (1, numSamples);
+        buffer.clear();
+        engine.renderNextBlock (buffer, events, params);
+        return buffer;
+    };
+
+    auto subtract = [] (juce::AudioBuffer<float> buffer, const juce::AudioBuffer<float>& other) {
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            buffer.setSample (0, i, buffer.getSample (0, i) - other.getSample (0, i));
+
+        return buffer;
+    };
+
+    // With every voice busy the second note steals the first, the quietest and oldest, mid-cycle
+    ArpEventList events;
+    events.add ({ 0, ArpEvent::Type::noteOn, 1, 69 });
+    addFillers (events);
+    events.add ({ 2412, ArpEvent::Type::noteOn, 1, 76 });
+
+    ArpEventList fillerEvents;
+    addFillers (fillerEvents);
+
+    SynthEngine engine, fillers;
+    engine.prepareToPlay (48000.0, params);
+    fillers.prepareToPlay (48000.0, params);
+
+    auto stolen = subtract (render (engine, events, 4800), render (fillers, fillerEvents, 4800));
+
+    CHECK (largestStep (stolen) < 0.1f);
+
+    // The stolen note still starts, as soon as the fade is over
+    const int fadeEnd = 2412 + static_cast<int> (SynthVoice::fadeOutSeconds * 48000.0);
+    CHECK (stolen.getMagnitude (0, fadeEnd + 480, 960) > 0.5f);
+
+    // One voice over the minimum playing, then the limit drops back and the newest one is trimmed
+    params.polyphony = SynthEngine::minPolyphony + 1;
+    ++params.version;
+    engine.prepareToPlay (48000.0, params);
+    fillers.prepareToPlay (48000.0, params);
+
+    events.clear();
+    addFillers (events);
+    events.add ({ 0, ArpEvent::Type::noteOn, 1, 69 });
+    events.add ({ 0, ArpEvent::Type::noteOn, 1, 76 });
+
+    fillerEvents.clear();
+    addFillers (fillerEvents);
+    fillerEvents.add ({ 0, ArpEvent::Type::noteOn, 1, 69 });
+
+    auto both = subtract (render (engine, events, 2412), render (fillers, fillerEvents, 2412));
+
+    params.polyphony = SynthEngine::minPolyphony;
+    ++params.version;
+    events.clear();
+
+    auto trimmed = subtract (render (engine, events, 2400), render (fillers, events, 2400));
+
+    CHECK (std::abs (trimmed.getSample (0, 0) - both.getSample (0, both.getNumSamples() - 1)) < 0.1f);
+    CHECK (largestStep (trimmed) < 0.1f);
+    CHECK (trimmed.getMagnitude (0, 480, 1920) == 0.0f);
+}
+
+TEST_CASE ("VoiceBank pan gains follow a constant-power law", "[synth]")
+{
+    // Power stays at that of a centred note, which plays at unity on both channels
+    for (float pan = -1.0f; pan <= 1.0f; pan += 0.125f)
+    {
+        auto gains = VoiceBank::getPanGains (pan);
+        CHECK (std::abs (gains.left * gains.left + gains.right * gains.right - 2.0f) < 1e-5f);
+    }
+
+    CHECK (VoiceBank::getPanGains (-1.0f).right == 0.0f);
+    CHECK (VoiceBank::getPanGains (1.0f).left == 0.0f);
+    CHECK (VoiceBank::getPanGains (0.0f).left == 1.0f);
+    CHECK (VoiceBank::getPanGains (0.0f).right == 1.0f);
+}
+
+TEST_CASE ("SynthEngine renders a mono bus without pan loss", "[synth]")
+{
+    ParameterSnapshot params;
+    params.gain = 1.0f;
+    params.envelope = { 0.001f, 0.001f, 1.0f, 0.001f, 1.0f };
+
+    auto render = [&] (int numChannels, float pan) {
+        SynthEngine engine;
+        engine.prepareToPlay (48000.0, params);
+
+        ArpEventList events;
+        events.add ({ 0, ArpEvent::Type::noteOn, 1, 69, pan });
+
+        juce::AudioBuffer<float> buffer (numChannels, 4800);
+        buffer.clear();
+        engine.renderNextBlock (buffer, events, params);
+        return buffer;
+    };
+
+    // A hard-panned note still reaches a mono bus at full level, and its side of a stereo bus at +3 dB
+    auto mono = render (1, -1.0f);
+    auto stereo = render (2, -1.0f);
+
+    CHECK (std::abs (mono.getMagnitude (0, 2400, 2400) - 1.0f) < 0.01f);
+    CHECK (std::abs (stereo.getMagnitude (0, 2400, 2400) - std::sqrt (2.0f)) < 0.01f);
+    CHECK (stereo.getMagnitude (1, 0, 4800) == 0.0f);
+
+    // At width 0 every note is centred and plays at unity on both channels, like the unpanned synth did
+    auto centred = render (2, 0.0f);
+
+    CHECK (std::abs (centred.getMagnitude (0, 2400, 2400) - 1.0f) < 0.01f);
+    CHECK (std::abs (centred.getMagnitude (1, 2400, 2400) - 1.0f) < 0.01f);
+    CHECK (centred.getMagnitude (0, 2400, 2400) == mono.getMagnitude (0, 2400, 2400));
+}
+
+TEST_CASE ("ADSR stages follow the expo curve", "[synth]")
+{
+    const double sampleRate = 48000.0;
+
+    for (float expo : { 0.1f, 3.0f, 10.0f })
+    {
+        ADSR adsr;
+        adsr.setSampleRate (sampleRate);
+        adsr.setParameters ({ 0.05f, 0.1f, 0.4f, 0.2f, expo });
+
+        float maxError = 0.0f;
+        auto check = [&] (float expected) { maxError = juce::jmax (maxError, std::abs (adsr.getNextSample() - expected)); };
+
+        // Each stage runs until its sample counter passes the stage length, the decay's counter starts at 1
+        auto attackSamples = 0.05 * sampleRate;
+        auto decaySamples = 0.1 * sampleRate;
+        auto releaseSamples = 0.2 * sampleRate;
+
+        adsr.noteOn();
+
+        for (int n = 0; n <= (int) attackSamples + 1; ++n)
+            check (ADSR::curve ((float) (n / attackSamples), expo, true));
+
+        for (int n = 1; n <= (int) decaySamples + 1; ++n)
+            check (ADSR::curve ((float) (n / decaySamples), expo, false) * 0.6f + 0.4f);
+
+        for (int n = 0; n < 1000; ++n)
+            check (0.4f);
+
+        adsr.noteOff();
+
+        for (int n = 0; n <= (int) releaseSamples; ++n)
+            check (ADSR::curve ((float) (n / releaseSamples), expo, false) * 0.4f);
+
+        // The sample that passes the end of the release is already silent
+        check (0.0f);
+
+        CHECK (maxError < 1e-5f);
+        CHECK (! adsr.isActive());
+    }
+}
+
+TEST_CASE ("ADSR with no delay or hold matches the previous attack, decay and release", "[synth]")
+{
+    const double sampleRate = 48000.0;
+
+    // Released in the attack, in the decay and in the sustain, and with stages of zero length
+    const std::pair<ADSR::Parameters, int> cases[] = {
+        { { 0.05f, 0.1f, 0.4f, 0.2f, 0.1f }, 20000 },
+        { { 0.05f, 0.1f, 0.4f, 0.2f, 5.0f }, 1000 },
+        { { 0.01f, 0.3f, 0.7f, 0.05f, 10.0f }, 4000 },
+        { { 0.0f, 0.02f, 0.5f, 0.1f, 3.0f }, 5000 },
+        { { 0.02f, 0.0f, 0.8f, 0.0f, 3.0f }, 3000 },
+        { { 0.0f, 0.0f, 0.3f, 0.01f, 1.0f }, 100 },
+    };
+
+    for (const auto& [parameters, heldSamples] : cases)
+    {
+        ADSR adsr;
+        adsr.setSampleRate (sampleRate);
+        adsr.setParameters (parameters);
+
+        ReferenceADSR reference (sampleRate, parameters);
+
+        // The old release ran one sample past its end, slightly below 0, where the segment list is already silent
+        float maxError = 0.0f;
+        auto compare = [&] { maxError = juce::jmax (maxError, std::abs (adsr.getNextSample() - juce::jmax (0.0f, reference.getNextSample()))); };
+
+        adsr.noteOn();
+        reference.noteOn();
+
+        for (int n = 0; n < heldSamples; ++n)
+            compare();
+
+        adsr.noteOff();
+        reference.noteOff();
+
+        for (int n = 0; n < (int) (parameters.release * sampleRate) + 10; ++n)
+            compare();
+
+        CHECK (maxError < 1e-5f);
+        CHECK (adsr.isActive() == reference.isActive());
+    }
+}
+
+TEST_CASE ("ADSR block rendering matches getNextSample", "[synth]")
+{
+    ADSR perSample, block;
+
+    for (auto* adsr : { &perSample, &block })
+    {
+        adsr->setSampleRate (44100.0);
+        adsr->setParameters ({ 0.01f, 0.02f, 0.5f, 0.03f, 4.0f });
+        adsr->noteOn();
+    }
+
+    // Odd chunk sizes so stage transitions land inside and on the edges of chunks
+    std::vector<float> values (4096);
+    int position = 0;
+
+    for (int chunk : { 1, 7, 300, 441, 2, 1000, 17, 882, 1, 500, 931 })
+    {
+        if (position > 2000 && block.isActive() && ! block.isReleasing())
+        {
+            perSample.noteOff();
+            block.noteOff();
+        }
+
+        block.renderEnvelope (values.data(), chunk, 1);
+
+        for (int i = 0; i < chunk; ++i)
+            CHECK (values[(size_t) i] == perSample.getNextSample());
+
+        position += chunk;
+    }
+
+    CHECK (! block.isActive());
+}
+
+TEST_CASE ("SynthEngine crossfades oscillator changes", "[synth]")
+{
+    ParameterSnapshot params;
+    params.gain = 1.0f;
+    params.envelope = { 0.001f, 0.001f, 1.0f, 0.001f, 1.0f };
+
+    SynthEngine engine;
+    engine.prepareToPlay (48000.0, params);
+
+    ArpEventList events;
+    events.add ({ 0, ArpEvent::Type::noteOn, 1, 45 });
+
+    juce::AudioBuffer<float> buffer (1, 4800);
+    buffer.clear();
+    engine.renderNextBlock (buffer, events, params);
+
+    // Switch from sine to square mid-note
+    params.waveform = Wavetables::square;
+    ++params.version;
+    events.clear();
+
+    juce::AudioBuffer<float> next (1, 4800);
+    next.clear();
+    engine.renderNextBlock (next, events, params);
+
+    // A 110 Hz note moves less than 0.02 per sample, with the crossfade the first samples after the switch do too
+    float largestStep = std::abs (next.getSample (0, 0) - buffer.getSample (0, 4799));
+
+    for (int i = 1; i < 100; ++i)
+        largestStep = juce::jmax (largestStep, std::abs (next.getSample (0, i) - next.getSample (0, i - 1)));
+
+    CHECK (largestStep < 0.05f);
+}
+
+TEST_CASE ("SynthEngine finishes a crossfade before the next oscillator change", "[synth]")
+{
+    ParameterSnapshot params;
+    params.gain = 1.0f;
+    params.envelope = { 0.001f, 0.001f, 1.0f, 0.001f, 1.0f };
+
+    SynthEngine engine;
+    engine.prepareToPlay (48000.0, params);
+
+    ArpEventList events;
+    events.add ({ 0, ArpEvent::Type::noteOn, 1, 45 });
+
+    juce::AudioBuffer<float> buffer (1, 4800);
+    buffer.clear();
+    engine.renderNextBlock (buffer, events, params);
+    events.clear();
+
+    float previous = buffer.getSample (0, 4799);
+    float largestStep = 0.0f;
+
+    // Sine to triangle and back 5 ms later, inside the first 20 ms crossfade, then 40 ms more so the second one runs too
+    for (auto waveform : { Wavetables::triangle, Wavetables::sine, Wavetables::sine, Wavetables::sine })
+    {
+        if (waveform != params.waveform)
+        {
+            params.waveform = waveform;
+            ++params.version;
+        }
+
+        juce::AudioBuffer<float> block (1, waveform == Wavetables::triangle ? 240 : 800);
+        block.clear();
+        engine.renderNextBlock (block, events, params);
+
+        for (int i = 0; i < block.getNumSamples(); ++i)
+        {
+            largestStep = juce::jmax (largestStep, std::abs (block.getSample (0, i) - previous));
+            previous = block.getSample (0, i);
+        }
+    }
+
+    // Both waveforms move less than 0.02 per sample at 110 Hz. Restarting the first crossfade would
+    // jump from its mix back to all triangle.
+    CHECK (largestStep < 0.02f);
+}
+
+TEST_CASE ("ADSR delay, hold and loop stages", "[synth]")
+{
+    ADSR adsr;
+    adsr.setSampleRate (1000.0);
+
+    ADSR::Parameters params { 0.01f, 0.01f, 0.5f, 0.01f, 3.0f };
+    params.delay = 0.005f;
+    params.hold = 0.02f;
+    adsr.setParameters (params);
+    adsr.noteOn();
+
+    std::vector<float> values (200);
+    adsr.renderEnvelope (values.data(), (int) values.size(), 1);
+
+    // Silent through the delay, at full level through the hold, then settles on the sustain
+    for (int n = 0; n <= 5; ++n)
+        CHECK (values[(size_t) n] == 0.0f);
+
+    for (int n = 18; n < 36; ++n)
+        CHECK (std::abs (values[(size_t) n] - 1.0f) < 1e-5f);
+
+    CHECK (values[199] == 0.5f);
+
+    // Looping repeats attack, hold and decay instead of sustaining
+    params.loop = true;
+    adsr.setParameters (params);
+    adsr.reset();
+    adsr.noteOn();
+    adsr.renderEnvelope (values.data(), (int) values.size(), 1);
+
+    int peaks = 0;
+
+    for (size_t n = 1; n < values.size(); ++n)
+        if (values[n] >= 1.0f - 1e-5f && values[n - 1] < 1.0f - 1e-5f)
+            ++peaks;
+
+    CHECK (peaks >= 4);
+    CHECK (! adsr.isReleasing());
+
+    adsr.noteOff();
+    CHECK (adsr.isReleasing());
+    adsr.renderEnvelope (values.data(), 20, 1);
+    CHECK (! adsr.isActive());
+}
@@ -0,0 +1,197 @@
+#include "RealtimeChecker.h"
+
+#include <mutex>
+#include <new>
+#include <utility>
+
+#if defined(__GLIBC__)
+    #include <cerrno>
+    #include <dlfcn.h>
+    #include <pthread.h>
+
+// glibc's own allocator, which the replacements below forward to
+extern "C"
+{
+    void* __libc_malloc (size_t size);
+    void* __libc_calloc (size_t num, size_t size);
+    void* __libc_realloc (void* ptr, size_t size);
+    void* __libc_memalign (size_t alignment, size_t size);
+    void __libc_free (void* ptr);
+}
+#endif
+
+namespace
+{
+    // Trivially initialised, so reading them never allocates, even from inside malloc
+    thread_local int sectionDepth = 0;
+    thread_local bool recording = false;
+
+    std::mutex violationsLock;
+
+    std::vector<RealtimeChecker::Violation>& getViolations()
+    {
+        static std::vector<RealtimeChecker::Violation> violations;
+        return violations;
+    }
+
+    /** Records a call if the current thread is in a real-time section. */
+    void check (const char* what) noexcept
+    {
+        // Recording allocates and locks too, which must not be reported again
+        if (sectionDepth == 0 || recording)
+            return;
+
+        recording = true;
+
+        {
+            RealtimeChecker::Violation violation { what, juce::SystemStats::getStackBacktrace() };
+
+            const std::lock_guard<std::mutex> lock (violationsLock);
+            getViolations().push_back (std::move (violation));
+        }
+
+        recording = false;
+    }
+}
+
+//==============================================================================
+void RealtimeCheck::enterSection() noexcept { ++sectionDepth; }
+
+void RealtimeCheck::exitSection() noexcept { --sectionDepth; }
+
+std::vector<RealtimeChecker::Violation> RealtimeChecker::takeViolations()
+{
+    const std::lock_guard<std::mutex> lock (violationsLock);
+    return std::exchange (getViolations(), {});
+}
+
+#if defined(__GLIBC__)
+
+bool RealtimeChecker::canDetectMalloc() noexcept { return true; }
+bool RealtimeChecker::canDetectLocks() noexcept { return true; }
+
+//==============================================================================
+// Replacing malloc and friends catches every allocation, operator new included
+extern "C"
+{
+    void* malloc (size_t size)
+    {
+        check ("malloc");
+        return __libc_malloc (size);
+    }
+
+    void* calloc (size_t num, size_t size)
+    {
+        check ("calloc");
+        return __libc_calloc (num, size);
+    }
+
+    void* realloc (void* ptr, size_t size)
+    {
+        check ("realloc");
+        return __libc_realloc (ptr, size);
+    }
+
+    void* memalign (size_t alignment, size_t size)
+    {
+        check ("memalign");
+        return __libc_memalign (alignment, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size)
+    {
+        check ("aligned_alloc");
+        return __libc_memalign (alignment, size);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size)
+    {
+        check ("posix_memalign");
+
+        if (alignment % sizeof (void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        auto* ptr = __libc_memalign (alignment, size);
+
+        if (ptr == nullptr)
+            return ENOMEM;
+
+        *result = ptr;
+        return 0;
+    }
+
+    void free (void* ptr)
+    {
+        if (ptr != nullptr)
+            check ("free");
+
+        __libc_free (ptr);
+    }
+
+    // Calls from this executable (JUCE's CriticalSection, std::mutex) land here before libpthread
+    int pthread_mutex_lock (pthread_mutex_t* mutex)
+    {
+        using LockFunction = int (*) (pthread_mutex_t*);
+        static std::atomic<LockFunction> next { nullptr };
+
+        auto lock = next.load (std::memory_order_relaxed);
+
+        if (lock == nullptr)
+        {
+            lock = reinterpret_cast<LockFunction> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+            next.store (lock, std::memory_order_relaxed);
+        }
+
+        check ("pthread_mutex_lock");
+        return lock (mutex);
+    }
+}
+
+#else
+
+bool RealtimeChecker::canDetectMalloc() noexcept { return false; }
+bool RealtimeChecker::canDetectLocks() noexcept { return false; }
+
+//==============================================================================
+// Without a replaceable malloc only C++ allocations can be seen
+void* operator new (size_t size)
+{
+    check ("operator new");
+
+    if (auto* ptr = std::malloc (size != 0 ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)
+{
+    return operator new (size);
+}
+
+void* operator new (size_t size, const std::nothrow_t&) noexcept
+{
+    check ("operator new");
+    return std::malloc (size != 0 ? size : 1);
+}
+
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new (size, std::nothrow);
+}
+
+void operator delete (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        check ("operator delete");
+
+    std::free (ptr);
+}
+
+void operator delete[] (void* ptr) noexcept { operator delete (ptr); }
+void operator delete (void* ptr, size_t) noexcept { operator delete (ptr); }
+void operator delete[] (void* ptr, size_t) noexcept { operator delete (ptr); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept { operator delete (ptr); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept { operator delete (ptr); }
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <RealtimeCheck.h>
+
+/* Reports allocations and locks made on the audio thread.
+ *
+ * RealtimeChecker.cpp replaces the allocator and pthread_mutex_lock for the whole
+ * test executable. While a thread is inside a RealtimeCheck::ScopedRealtimeSection
+ * (processBlock() opens one), every malloc, free and mutex lock it makes is recorded
+ * with a stack trace; everywhere else they pass straight through.
+ *
+ * Allocations and locks are intercepted with glibc. Other platforms only see C++
+ * operator new and delete, check canDetectLocks() before relying on the rest.
+ *
+ * Example usage
+ *
+  RealtimeChecker::takeViolations(); // forget anything earlier tests left behind
+
+  plugin.processBlock (buffer, midi);
+
+  for (const auto& violation : RealtimeChecker::takeViolations())
+      FAIL (violation.what << "\n" << violation.stackTrace);
+ */
+namespace RealtimeChecker
+{
+    struct Violation
+    {
+        juce::String what; // the call that was made, e.g. "malloc"
+        juce::String stackTrace;
+    };
+
+    /** Returns the violations recorded since the last call, and forgets them. */
+    std::vector<Violation> takeViolations();
+
+    /** True if C allocations (malloc, HeapBlock, ...) are seen, not just operator new. */
+    bool canDetectMalloc() noexcept;
+
+    /** True if mutex locks are seen. */
+    bool canDetectLocks() noexcept;
+}